@@ -0,0 +1,46 @@
+"""
+Minimal Modbus TCP client used as a stand-in for external software.
+
+Polls the water tank PLC exposed by modbus_gateway.py, reading the pump
+and valve coils and the level sensor input register once per second.
+"""
+import socket
+import struct
+import time
+
+HOST = "127.0.0.1"
+PORT = 5020
+UNIT_ID = 1
+
+READ_COILS = 1
+READ_INPUT_REGISTERS = 4
+
+transaction_id = 0
+
+def request(sock, function_code, start, count):
+    global transaction_id
+    transaction_id = (transaction_id + 1) & 0xFFFF
+
+    # MBAP header (tid, protocol 0, length, unit id) followed by the PDU
+    sock.sendall(struct.pack(">HHHBBHH", transaction_id, 0, 6, UNIT_ID, function_code, start, count))
+
+    header = sock.recv(7, socket.MSG_WAITALL)
+    tid, _, length, _ = struct.unpack(">HHHB", header)
+    pdu = sock.recv(length - 1, socket.MSG_WAITALL)
+
+    if tid != transaction_id:
+        raise RuntimeError(f"Unexpected transaction id {tid}")
+
+    return pdu
+
+with socket.create_connection((HOST, PORT)) as sock:
+    while True:
+        coils = request(sock, READ_COILS, 0, 2)
+        registers = request(sock, READ_INPUT_REGISTERS, 0, 1)
+
+        pump = coils[2] & 0x01
+        valve = (coils[2] >> 1) & 0x01
+        level = struct.unpack(">H", registers[2:4])[0] * 10 / 0xFFFF
+
+        print(f"pump={pump} valve={valve} level={level:.3f}m")
+        time.sleep(1)
@@ -0,0 +1,53 @@
+"""
+Exposes a simulated PLC to Modbus TCP software running on the host.
+
+The water tank PLC is served on 127.0.0.1:5020 (unit id 1) by a Modbus
+gateway, so any Modbus TCP client (an HMI, a historian or the bundled
+modbus_client.py stand-in) can read its coils and input registers while
+the simulation runs paced with the wall clock.
+
+    terminal 1: python3 modbus_gateway.py
+    terminal 2: python3 modbus_client.py
+"""
+from tinyics import *
+
+GATEWAY_PORT = 5020
+SIMULATION_TIME = 120
+
+class PlcWT(Plc):
+    level_down_height = 0.2;    # 0.2m minimum water level in the tank
+    level_up_height = 0.5;      # 0.5m maximum water level in the tank
+
+    def __init__(self, name):
+        super().__init__(name)
+        self.link_process(process.WaterTank())
+
+    def Update(self, measured, plc_out) -> PlcState:
+        height = scale_word_to_range(measured.get_analog_state(self.process.LEVEL_SENSOR), 0, 10)
+
+        if height >= self.level_up_height:
+            plc_out.set_digital_state(self.process.PUMP, False);
+            plc_out.set_digital_state(self.process.VALVE, True);
+
+        elif not height >= self.level_down_height:
+            plc_out.set_digital_state(self.process.PUMP, True);
+            plc_out.set_digital_state(self.process.VALVE, False);
+
+        return plc_out
+
+plc_wt = PlcWT("water_control")
+
+networkBuilder = IndustrialNetworkBuilder(Ipv4Address("192.168.1.0"), Ipv4Mask("255.255.255.0"))
+networkBuilder.add_to_network(plc_wt)
+networkBuilder.build_network()
+
+gateway = ModbusGateway()
+gateway.add_plc(GATEWAY_PORT, 1, plc_wt)
+gateway.start()
+
+# Keep the simulated clock in step with the wall clock
+set_run_mode(RunMode.Paced)
+run_simulation(SIMULATION_TIME)
+
+metrics = get_run_metrics()
+print(f"Served {gateway.get_request_count()} requests, max lag {metrics.max_lag * 1000:.2f}ms")
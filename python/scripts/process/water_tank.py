@@ -1,3 +1,5 @@
+import pickle
+
 from tinyics.python.bindings.industrial_networks import *
 
 """
@@ -63,6 +65,17 @@ class WaterTank(IndustrialProcess):
         return state
 
 
+    """
+    Store the state of the process in a snapshot. The previous time is not
+    stored since a restored simulation starts its clock from zero again.
+    """
+    def Serialize(self):
+        return pickle.dumps(self.curr_height)
+
+    def Deserialize(self, data):
+        self.curr_height = pickle.loads(data)
+        self.prev_time = get_current_time()
+
     """
     Define the position of the sensors and actuator as coils from the PLC
     """
@@ -28,15 +28,17 @@
  *                 Tank
  */
 
+#include "continuous-process.h"
 #include "industrial-process.h"
 #include "industrial-network-builder.h"
 
 /**
  * A Water Tank system
  *
- * It contains two level sensors, a pump and a valve
+ * It contains two level sensors, a pump and a valve. The level is
+ * integrated by the plant from dh/dt = (pump - valve flow) / tank width.
  */
-class WaterTank : public IndustrialProcess
+class WaterTank : public ContinuousProcess
 {
 public:
     // SENSORS
@@ -46,32 +48,29 @@ public:
     static constexpr uint8_t PUMP_POS = 0;
     static constexpr uint8_t VALVE_POS = 1;
 
-    WaterTank()
+    WaterTank() : ContinuousProcess(1)
     {
         m_currHeight = AnalogSensor(0, 10);
-    }
-    ~WaterTank() = default;
 
-    void UpdateProcess(PlcState* state, const PlcState* input) override
-    {
-        auto current = ns3::Simulator::Now().ToDouble(ns3::Time::S);
+        SetKernel(
+            [](double t, const double *x, double *dxdt, const PlcState *input, const double *) {
+                dxdt[0] = 0;
 
-        bool pupmOn = input->GetDigitalState(PUMP_POS);
-        bool valveOn = input->GetDigitalState(VALVE_POS);
+                if (input->GetDigitalState(PUMP_POS))
+                    dxdt[0] += s_pumpFlow / s_tankWidth;
 
-        if (pupmOn)
-        {
-            m_currHeight += s_pumpFlow * (current - m_prevTime) / s_tankWidth;
-        }
-        if (valveOn)
-        {
-            m_currHeight -= s_valveFlow * (current - m_prevTime) / s_tankWidth;
-        }
+                if (input->GetDigitalState(VALVE_POS))
+                    dxdt[0] -= s_valveFlow / s_tankWidth;
+            });
+    }
+    ~WaterTank() = default;
 
-        m_prevTime = current;
+    void Measure(const std::vector<double> &state, PlcState *measurements) override
+    {
+        m_currHeight = state[0];
 
         // update level sensor
-        state->SetAnalogState(LEVEL_SENSOR_POS, m_currHeight);
+        measurements->SetAnalogState(LEVEL_SENSOR_POS, m_currHeight);
     }
 
 private:
@@ -79,11 +78,9 @@ private:
     static constexpr float s_pumpFlow = 0.1;   // 0.1 m/s = 10cm/s
     static constexpr float s_valveFlow = 0.05; // 0.05 m/s = 5cm/s
 
-    double m_prevTime;
     AnalogSensor m_currHeight;
 };
 
-
 class Semaphore : public IndustrialProcess
 {
 public:
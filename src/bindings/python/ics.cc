@@ -1,21 +1,54 @@
+#include "async-runner.h"
+#include "continuous-process.h"
+#include "historian.h"
 #include "industrial-process.h"
 #include "industrial-network-builder.h"
 #include "industrial-plant.h"
+#ifdef __linux__
+#include "modbus-gateway.h"
+#endif
+#include "modbus-rtu-gateway.h"
+#include "plc-host.h"
+#include "profiler.h"
 #include "scada-application.h"
+#include "scenario.h"
+#include "simulation-runner.h"
+#include "snapshot.h"
+#include "stats-publisher.h"
 
 #include <pybind11/pybind11.h>
 #include <pybind11/functional.h>
 #include <pybind11/stl.h>
 #include <pybind11/pytypes.h>
 
+#include <limits>
+#include <sstream>
+
 namespace py = pybind11;
 
+/*
+ * The simulation runs without the GIL (on a background thread with run_async),
+ * every call into Python from it must take the GIL first.
+ */
+
+/// Name of the Python class overriding a trampoline, profiles are kept per class
+template <typename T>
+std::string
+GetPythonClass(const T *self)
+{
+    return py::str(py::cast(self).get_type().attr("__name__"));
+}
+
 class IndustrialProcessTrampoline : public IndustrialProcess
 {
 public:
     /// Updates the state of the Process
     void UpdateProcess(PlcState *state, const PlcState *input) override
     {
+        py::gil_scoped_acquire gil;
+        TINYICS_PROFILE_SCOPE("python", GetPythonClass(this));
+        StatsTimer timer(StatsPublisher::GetPythonCallbacks());
+
         PYBIND11_OVERLOAD_PURE(
             void,
             IndustrialProcess,
@@ -23,6 +56,51 @@ public:
             state, input
         );
     }
+
+    /// Python processes return their state as bytes
+    std::string Serialize() const override
+    {
+        PYBIND11_OVERLOAD(
+            std::string,
+            IndustrialProcess,
+            Serialize,
+        );
+    }
+
+    void Deserialize(const std::string &state) override
+    {
+        py::gil_scoped_acquire gil;
+
+        // Passed as bytes, the state is not expected to be valid UTF-8
+        py::function override = py::get_override(this, "Deserialize");
+        if (override)
+        {
+            override(py::bytes(state));
+            return;
+        }
+
+        IndustrialProcess::Deserialize(state);
+    }
+};
+
+class ContinuousProcessTrampoline : public ContinuousProcess
+{
+public:
+    using ContinuousProcess::ContinuousProcess;
+
+    void Measure(const std::vector<double> &state, PlcState *measurements) override
+    {
+        py::gil_scoped_acquire gil;
+        TINYICS_PROFILE_SCOPE("python", GetPythonClass(this));
+        StatsTimer timer(StatsPublisher::GetPythonCallbacks());
+
+        PYBIND11_OVERLOAD_PURE(
+            void,
+            ContinuousProcess,
+            Measure,
+            state, measurements
+        );
+    }
 };
 
 class ScadaTrampoline : public ScadaApplication
@@ -32,6 +110,10 @@ public:
 
     void Update(const std::map<std::string, Var>& vars) override
     {
+        py::gil_scoped_acquire gil;
+        TINYICS_PROFILE_SCOPE("python", GetPythonClass(this));
+        StatsTimer timer(StatsPublisher::GetPythonCallbacks());
+
         PYBIND11_OVERLOAD(
             void,
             ScadaApplication,
@@ -39,6 +121,20 @@ public:
             vars
         );
     }
+
+    void OnChange(const std::map<std::string, Var>& changed) override
+    {
+        py::gil_scoped_acquire gil;
+        TINYICS_PROFILE_SCOPE("python", GetPythonClass(this));
+        StatsTimer timer(StatsPublisher::GetPythonCallbacks());
+
+        PYBIND11_OVERLOAD(
+            void,
+            ScadaApplication,
+            OnChange,
+            changed
+        );
+    }
 };
 
 class PlcTrampoline : public PlcApplication
@@ -48,6 +144,10 @@ public:
 
     void Update(const PlcState *measured, PlcState *plc_out) override
     {
+        py::gil_scoped_acquire gil;
+        TINYICS_PROFILE_SCOPE("python", GetPythonClass(this));
+        StatsTimer timer(StatsPublisher::GetPythonCallbacks());
+
         PYBIND11_OVERLOAD(
             void,
             PlcApplication,
@@ -60,9 +160,7 @@ public:
 void
 RunSimulationWrapper(double time = 20.0)
 {
-    ns3::Simulator::Stop(ns3::Seconds(time));
-    ns3::Simulator::Run();
-    ns3::Simulator::Destroy();
+    SimulationRunner::Run(time);
 }
 
 
@@ -99,16 +197,114 @@ PYBIND11_MODULE(industrial_networks, m)
             static_cast<void(PlcApplication::*)(std::shared_ptr<IndustrialProcess>, uint8_t)>(&PlcApplication::LinkProcess)
         )
         .def("Update", &PlcApplication::Update)
-        .def("get_address", &PlcApplication::GetAddress);
+        .def("get_address", &PlcApplication::GetAddress)
+        .def("set_max_connections", &PlcApplication::SetMaxConnections)
+        .def("set_queue_depth", &PlcApplication::SetQueueDepth)
+        .def("get_connection_count", &PlcApplication::GetConnectionCount)
+        .def("get_busy_requests", &PlcApplication::GetBusyRequests)
+        .def("get_malformed_requests", &PlcApplication::GetMalformedRequests)
+        .def("set_batching", &PlcApplication::SetBatching)
+        .def("get_packets_sent", [](const PlcApplication &plc) {
+            return plc.GetBatcher().GetPacketsSent();
+        })
+        .def("get_adus_sent", [](const PlcApplication &plc) {
+            return plc.GetBatcher().GetAdusSent();
+        });
 
     py::class_<ScadaApplication, IndustrialApplication, ScadaTrampoline, ns3::Ptr<ScadaApplication>>(m, "Scada")
         .def(py::init<const char*>())
         .def(py::init<const char*, uint64_t>())
         .def("add_variable", static_cast<void (ScadaApplication::*)(const ns3::Ptr<PlcApplication>&, const std::string&, VarType, uint8_t)>(&ScadaApplication::AddVariable))
-        .def("add_rtu", py::overload_cast<ns3::Ipv4Address>(&ScadaApplication::AddRTU))
+        .def("add_variable", static_cast<void (ScadaApplication::*)(size_t, const std::string&, VarType, uint8_t)>(&ScadaApplication::AddVariable))
+        .def("add_rtu", &ScadaApplication::AddRTU, py::arg("addr"), py::arg("uid") = 1)
+        .def("get_rtu", &ScadaApplication::GetRTU, py::arg("addr"), py::arg("uid") = 1)
+        .def("get_rtu_count", &ScadaApplication::GetRTUCount)
         .def("Update", &ScadaApplication::Update)
+        .def("OnChange", &ScadaApplication::OnChange)
         .def("_write", &ScadaApplication::Write)
-        .def("set_refresh_rate", &ScadaApplication::SetRefreshRate);
+        .def("set_report_by_exception", &ScadaApplication::SetReportByException)
+        .def("set_deadband", &ScadaApplication::SetDeadband)
+        .def("set_refresh_rate", &ScadaApplication::SetRefreshRate)
+        .def("set_timeout", &ScadaApplication::SetTimeout)
+        .def("set_retries", &ScadaApplication::SetRetries)
+        .def("set_busy_delay", &ScadaApplication::SetBusyDelay)
+        .def("set_max_outstanding", &ScadaApplication::SetMaxOutstanding)
+        .def("get_skipped_cycles", &ScadaApplication::GetSkippedCycles)
+        .def("get_exception_count", &ScadaApplication::GetExceptionCount)
+        .def("set_staggered_polling", &ScadaApplication::SetStaggeredPolling)
+        .def("set_poll_schedule", &ScadaApplication::SetPollSchedule,
+             py::arg("rtu"), py::arg("rate"), py::arg("phase") = -1,
+             py::arg("priority") = PollPriority::Normal)
+        .def("set_max_concurrent_polls", &ScadaApplication::SetMaxConcurrentPolls)
+        .def("get_deferred_polls", &ScadaApplication::GetDeferredPolls)
+        .def("get_skipped_polls", &ScadaApplication::GetSkippedPolls)
+        .def("set_batching", &ScadaApplication::SetBatching)
+        .def("get_packets_sent", [](const ScadaApplication &scada) {
+            return scada.GetBatcher().GetPacketsSent();
+        })
+        .def("get_adus_sent", [](const ScadaApplication &scada) {
+            return scada.GetBatcher().GetAdusSent();
+        })
+        .def("enable_tracing", &ScadaApplication::EnableTracing, py::arg("enable") = true)
+        .def("get_transaction_stats", [](const ScadaApplication &scada) {
+            return scada.GetTracer().GetStats();
+        })
+        .def("print_transaction_stats", [](const ScadaApplication &scada) {
+            scada.GetTracer().Print(std::cout);
+        });
+
+    py::class_<TimeSample>(m, "TimeSample")
+        .def_readonly("time", &TimeSample::time)
+        .def_readonly("value", &TimeSample::value);
+
+    py::class_<TimeBucket>(m, "TimeBucket")
+        .def_readonly("start", &TimeBucket::start)
+        .def_readonly("count", &TimeBucket::count)
+        .def_readonly("min", &TimeBucket::min)
+        .def_readonly("max", &TimeBucket::max)
+        .def_readonly("mean", &TimeBucket::mean)
+        .def_readonly("last", &TimeBucket::last);
+
+    py::class_<Historian, ScadaApplication, ns3::Ptr<Historian>>(m, "Historian")
+        .def(py::init<const char*>())
+        .def(py::init<const char*, uint64_t>())
+        .def("set_record_on_change", &Historian::SetRecordOnChange)
+        .def("set_retention", &Historian::SetRetention)
+        .def("set_memory_limit", &Historian::SetMemoryLimit)
+        .def("query", &Historian::Query, py::arg("tag"), py::arg("start") = 0.0,
+             py::arg("end") = std::numeric_limits<double>::infinity())
+        .def("downsample", &Historian::Downsample, py::arg("tag"), py::arg("start"),
+             py::arg("end"), py::arg("step"))
+        .def("get_tags", &Historian::GetTags)
+        .def("get_sample_count", &Historian::GetSampleCount)
+        .def("get_memory_usage", &Historian::GetMemoryUsage);
+
+    py::enum_<PollPriority>(m, "PollPriority")
+        .value("High", PollPriority::High)
+        .value("Normal", PollPriority::Normal)
+        .value("Low", PollPriority::Low);
+
+    py::enum_<MB_FunctionCode>(m, "FunctionCode")
+        .value("ReadCoils", MB_FunctionCode::ReadCoils)
+        .value("ReadDiscreteInputs", MB_FunctionCode::ReadDiscreteInputs)
+        .value("ReadInputRegisters", MB_FunctionCode::ReadInputRegisters)
+        .value("WriteSingleCoil", MB_FunctionCode::WriteSingleCoil)
+        .value("WriteMultipleCoils", MB_FunctionCode::WriteMultipleCoils);
+
+    py::class_<LatencyHistogram>(m, "LatencyHistogram")
+        .def("get_count", &LatencyHistogram::GetCount)
+        .def("get_min", &LatencyHistogram::GetMin)
+        .def("get_max", &LatencyHistogram::GetMax)
+        .def("get_mean", &LatencyHistogram::GetMean)
+        .def("get_percentile", &LatencyHistogram::GetPercentile);
+
+    py::class_<TransactionStats>(m, "TransactionStats")
+        .def_readonly("requests", &TransactionStats::requests)
+        .def_readonly("responses", &TransactionStats::responses)
+        .def_readonly("timeouts", &TransactionStats::timeouts)
+        .def_readonly("retries", &TransactionStats::retries)
+        .def_readonly("exceptions", &TransactionStats::exceptions)
+        .def_readonly("latency", &TransactionStats::latency);
 
     py::enum_<VarType>(m, "VarType")
         .value("Coil", VarType::Coil)
@@ -117,13 +313,35 @@ PYBIND11_MODULE(industrial_networks, m)
 
     py::class_<Var>(m, "Var")
         .def("get_value", &Var::GetValue)
-        .def("set_value", &Var::SetValue);
+        .def("set_value", &Var::SetValue)
+        .def("get_deadband", &Var::GetDeadband);
 
     py::class_<IndustrialNetworkBuilder>(m, "IndustrialNetworkBuilder")
         .def(py::init<ns3::Ipv4Address, ns3::Ipv4Mask>())
-        .def("add_to_network", &IndustrialNetworkBuilder::AddToNetwork)
+        .def("add_to_network", py::overload_cast<ns3::Ptr<IndustrialApplication>>(&IndustrialNetworkBuilder::AddToNetwork))
+        .def("add_to_network", py::overload_cast<const std::vector<ns3::Ptr<IndustrialApplication>> &>(&IndustrialNetworkBuilder::AddToNetwork))
+        .def("reserve", &IndustrialNetworkBuilder::Reserve)
+        .def("set_name_registration", &IndustrialNetworkBuilder::SetNameRegistration)
+        .def("set_verbose", &IndustrialNetworkBuilder::SetVerbose)
+        .def("set_lightweight_stack", &IndustrialNetworkBuilder::SetLightweightStack)
         .def("build_network", &IndustrialNetworkBuilder::BuildNetwork)
-        .def("enable_pcap", &IndustrialNetworkBuilder::EnablePcap);
+        .def("enable_pcap", &IndustrialNetworkBuilder::EnablePcap)
+        .def("get_profile", &IndustrialNetworkBuilder::GetProfile);
+
+    py::class_<BuildProfile>(m, "BuildProfile")
+        .def_readonly("nodes", &BuildProfile::nodes)
+        .def_readonly("add_time", &BuildProfile::addTime)
+        .def_readonly("stack_time", &BuildProfile::stackTime)
+        .def_readonly("device_time", &BuildProfile::deviceTime)
+        .def_readonly("address_time", &BuildProfile::addressTime)
+        .def_readonly("total_time", &BuildProfile::totalTime)
+        .def_readonly("memory", &BuildProfile::memory)
+        .def_readonly("memory_per_node", &BuildProfile::memoryPerNode)
+        .def("__str__", [](const BuildProfile &profile) {
+            std::ostringstream os;
+            profile.Print(os);
+            return os.str();
+        });
 
     py::class_<ns3::Ipv4Address>(m, "Ipv4Address")
         .def(py::init<const char*>());
@@ -133,15 +351,110 @@ PYBIND11_MODULE(industrial_networks, m)
 
     py::class_<IndustrialProcess, IndustrialProcessTrampoline, std::shared_ptr<IndustrialProcess>>(m, "IndustrialProcess")
         .def(py::init<>())
-        .def("update_process", &IndustrialProcess::UpdateProcess);
+        .def("update_process", &IndustrialProcess::UpdateProcess)
+        .def("Serialize", [](const IndustrialProcess &process) {
+            return py::bytes(process.Serialize());
+        })
+        .def("Deserialize", &IndustrialProcess::Deserialize);
+
+    py::enum_<Integrator>(m, "Integrator")
+        .value("RK4", Integrator::RK4)
+        .value("DormandPrince", Integrator::DormandPrince);
+
+    py::class_<ContinuousProcess, IndustrialProcess, ContinuousProcessTrampoline, std::shared_ptr<ContinuousProcess>>(m, "ContinuousProcess")
+        .def(py::init<size_t, Integrator>(), py::arg("dimension"), py::arg("integrator") = Integrator::RK4)
+        .def("set_kernel", py::overload_cast<const std::string &>(&ContinuousProcess::SetKernel))
+        .def("set_derivative", [](ContinuousProcess &process, py::function derivative) {
+            // Calls back into Python on every stage, registered kernels are much faster
+            size_t n = process.GetState().size();
+            process.SetKernel([derivative, n](double t, const double *x, double *dxdt, const PlcState *input, const double *) {
+                py::gil_scoped_acquire gil;
+                auto result = derivative(t, std::vector<double>(x, x + n), input).cast<std::vector<double>>();
+
+                if (result.size() != n)
+                    throw py::value_error("The derivative must have the size of the state");
+
+                std::copy(result.begin(), result.end(), dxdt);
+            });
+        })
+        .def("set_parameters", &ContinuousProcess::SetParameters)
+        .def("set_integrator", &ContinuousProcess::SetIntegrator)
+        .def("set_max_step", &ContinuousProcess::SetMaxStep)
+        .def("set_tolerance", &ContinuousProcess::SetTolerance, py::arg("absolute"), py::arg("relative"))
+        .def("get_state", &ContinuousProcess::GetState)
+        .def("set_state", &ContinuousProcess::SetState)
+        .def("get_time", &ContinuousProcess::GetTime)
+        .def("get_step_count", &ContinuousProcess::GetStepCount)
+        .def("get_rejected_count", &ContinuousProcess::GetRejectedCount);
 
     py::class_<PlcState>(m, "PlcState")
         .def(py::init<>())
         .def("get_digital_state", &PlcState::GetDigitalState)
         .def("set_digital_state", &PlcState::SetDigitalState)
         .def("get_analog_state", &PlcState::GetAnalogState)
-        .def("set_analog_state", py::overload_cast<uint8_t, const AnalogSensor&>(&PlcState::SetAnalogState))
-        .def("set_analog_state", py::overload_cast<uint8_t, double>(&PlcState::SetAnalogState));
+        .def("set_analog_state", py::overload_cast<uint8_t, AnalogSensor&>(&PlcState::SetAnalogState))
+        .def("set_analog_state", py::overload_cast<uint8_t, double>(&PlcState::SetAnalogState))
+        .def("set_analog_states", [](PlcState &state, uint8_t start, const std::vector<double> &values) {
+            state.SetAnalogStates(start, values.data(), values.size());
+        })
+        .def("get_analog_range", &PlcState::GetAnalogRange)
+        .def("set_analog_resolution", &PlcState::SetAnalogResolution)
+        .def("get_analog_full_scale", &PlcState::GetAnalogFullScale);
+
+    py::enum_<AnalogRange>(m, "AnalogRange")
+        .value("InRange", AnalogRange::InRange)
+        .value("UnderRange", AnalogRange::UnderRange)
+        .value("OverRange", AnalogRange::OverRange);
+
+    py::class_<AnalogConverter>(m, "AnalogConverter")
+        .def(py::init<double, double, uint8_t>(), py::arg("min"), py::arg("max"), py::arg("resolution") = 16)
+        .def("set_range", &AnalogConverter::SetRange)
+        .def("set_resolution", &AnalogConverter::SetResolution)
+        .def("get_resolution", &AnalogConverter::GetResolution)
+        .def("get_full_scale", &AnalogConverter::GetFullScale)
+        .def("to_counts", [](const AnalogConverter &adc, double value) {
+            return adc.ToCounts(value);
+        })
+        .def("to_value", &AnalogConverter::ToValue)
+        .def("to_counts_batch", [](const AnalogConverter &adc, const std::vector<double> &values) {
+            std::vector<uint16_t> counts(values.size());
+            std::vector<AnalogRange> ranges(values.size());
+            adc.ToCounts(values.data(), counts.data(), values.size(), ranges.data());
+            return std::make_tuple(counts, ranges);
+        })
+        .def("to_values_batch", [](const AnalogConverter &adc, const std::vector<uint16_t> &counts) {
+            std::vector<double> values(counts.size());
+            adc.ToValues(counts.data(), values.data(), counts.size());
+            return values;
+        });
+
+    py::class_<SensorModel, std::shared_ptr<SensorModel>>(m, "SensorModel")
+        .def(py::init<uint64_t>(), py::arg("id"))
+        .def_static("set_run_seed", &SensorModel::SetRunSeed)
+        .def_static("get_run_seed", &SensorModel::GetRunSeed)
+        .def("set_noise", &SensorModel::SetNoise)
+        .def("set_quantization", &SensorModel::SetQuantization)
+        .def("set_bias", &SensorModel::SetBias)
+        .def("set_drift", &SensorModel::SetDrift)
+        .def("set_stuck_probability", &SensorModel::SetStuckProbability)
+        .def("stick", &SensorModel::Stick)
+        .def("unstick", &SensorModel::Unstick)
+        .def("is_stuck", &SensorModel::IsStuck)
+        .def("get_id", &SensorModel::GetId)
+        .def("get_sample_count", &SensorModel::GetSampleCount)
+        .def("sample", &SensorModel::Sample)
+        .def(py::pickle(
+            [](const SensorModel &model) {
+                SnapshotWriter writer;
+                model.Serialize(writer);
+                return py::bytes(writer.GetBuffer());
+            },
+            [](const py::bytes &state) {
+                SnapshotReader reader(state);
+                auto model = std::make_shared<SensorModel>(0);
+                model->Deserialize(reader);
+                return model;
+            }));
 
     py::class_<AnalogSensor>(m, "AnalogSensor")
         .def(py::init<>())
@@ -149,6 +462,22 @@ PYBIND11_MODULE(industrial_networks, m)
         .def(py::init<double, double, double>())
         .def("get_value", &AnalogSensor::GetValue)
         .def("set_value", &AnalogSensor::SetValue)
+        .def("get_measured_value", &AnalogSensor::GetMeasuredValue)
+        .def("sample", &AnalogSensor::Sample)
+        .def("set_model", &AnalogSensor::SetModel)
+        .def("get_model", &AnalogSensor::GetModel)
+        .def(py::pickle(
+            [](const AnalogSensor &sensor) {
+                return py::make_tuple(sensor.GetMin(), sensor.GetMax(), sensor.GetValue(),
+                                      sensor.GetModel());
+            },
+            [](py::tuple state) {
+                AnalogSensor sensor(state[0].cast<double>(),
+                                    state[1].cast<double>(),
+                                    state[2].cast<double>());
+                sensor.SetModel(state[3].cast<std::shared_ptr<SensorModel>>());
+                return sensor;
+            }))
         .def("__iadd__", &AnalogSensor::operator+=)
         .def("__isub__", &AnalogSensor::operator-=)
         .def("__imul__", &AnalogSensor::operator*=)
@@ -159,14 +488,155 @@ PYBIND11_MODULE(industrial_networks, m)
         .def("__le__", &AnalogSensor::operator<=)
         .def("__ge__", &AnalogSensor::operator>=);
 
+#ifdef __linux__
+    py::class_<ModbusGateway>(m, "ModbusGateway")
+        .def(py::init<>())
+        .def("add_plc", &ModbusGateway::AddPLC, py::arg("port"), py::arg("uid"), py::arg("plc"))
+        .def("start", &ModbusGateway::Start, py::arg("interval") = 1)
+        .def("stop", &ModbusGateway::Stop)
+        .def("get_client_count", &ModbusGateway::GetClientCount)
+        .def("get_request_count", &ModbusGateway::GetRequestCount);
+#endif
+
+    py::class_<SerialBus, std::shared_ptr<SerialBus>>(m, "SerialBus")
+        .def(py::init<uint32_t, uint8_t>(), py::arg("baud") = 19200, py::arg("bits_per_char") = 11)
+        .def("set_baud_rate", &SerialBus::SetBaudRate)
+        .def("set_turnaround", [](SerialBus &bus, uint64_t turnaround) {
+            bus.SetTurnaround(ns3::MilliSeconds(turnaround));
+        })
+        .def("attach_slave", &SerialBus::AttachSlave)
+        .def("get_frame_count", &SerialBus::GetFrameCount)
+        .def("get_discarded_count", &SerialBus::GetDiscardedCount)
+        .def("get_utilization", &SerialBus::GetUtilization);
+
+    py::class_<ModbusRtuGateway, IndustrialApplication, ns3::Ptr<ModbusRtuGateway>>(m, "ModbusRtuGateway")
+        .def(py::init<const char*, std::shared_ptr<SerialBus>>())
+        .def("get_address", &ModbusRtuGateway::GetAddress)
+        .def("set_response_timeout", &ModbusRtuGateway::SetResponseTimeout)
+        .def("get_request_count", &ModbusRtuGateway::GetRequestCount)
+        .def("get_timeout_count", &ModbusRtuGateway::GetTimeoutCount)
+        .def("get_queue_length", &ModbusRtuGateway::GetQueueLength);
+
+    py::class_<PlcHost, IndustrialApplication, ns3::Ptr<PlcHost>>(m, "PlcHost")
+        .def(py::init<const char*>())
+        .def("get_address", &PlcHost::GetAddress)
+        .def("add_unit", &PlcHost::AddUnit, py::arg("uid"), py::arg("plc"))
+        .def("get_unit", &PlcHost::GetUnit)
+        .def("get_unit_count", &PlcHost::GetUnitCount)
+        .def("set_max_connections", &PlcHost::SetMaxConnections)
+        .def("set_queue_depth", &PlcHost::SetQueueDepth)
+        .def("get_connection_count", &PlcHost::GetConnectionCount)
+        .def("get_busy_requests", &PlcHost::GetBusyRequests)
+        .def("get_unrouted_requests", &PlcHost::GetUnroutedRequests)
+        .def("get_malformed_requests", &PlcHost::GetMalformedRequests)
+        .def("set_batching", &PlcHost::SetBatching);
+
     py::class_<IndustrialPlant>(m, "IndustrialPlant")
         .def("set_refresh_rate", &IndustrialPlant::SetRefreshRate);
 
     // Functions
-    m.def("run_simulation", &RunSimulationWrapper, py::arg("time") = 20.0);
+    m.def("run_simulation", &RunSimulationWrapper, py::arg("time") = 20.0,
+          py::call_guard<py::gil_scoped_release>());
 
     m.def("get_current_time", &GetCurrentTime);
 
+    py::enum_<RunMode>(m, "RunMode")
+        .value("Unpaced", RunMode::Unpaced)
+        .value("Paced", RunMode::Paced);
+
+    py::class_<RunMetrics>(m, "RunMetrics")
+        .def_readonly("simulated_time", &RunMetrics::simulatedTime)
+        .def_readonly("wall_time", &RunMetrics::wallTime)
+        .def_readonly("speedup", &RunMetrics::speedup)
+        .def_readonly("lag", &RunMetrics::lag)
+        .def_readonly("max_lag", &RunMetrics::maxLag)
+        .def_readonly("mean_lag", &RunMetrics::meanLag)
+        .def_readonly("ticks", &RunMetrics::ticks)
+        .def_readonly("overruns", &RunMetrics::overruns)
+        .def_readonly("events", &RunMetrics::events);
+
+    m.def("set_run_mode", &SimulationRunner::SetMode);
+
+    m.def("set_pacing", &SimulationRunner::SetPacing, py::arg("scale") = 1.0, py::arg("interval") = 10);
+
+    m.def("get_run_metrics", &SimulationRunner::GetMetrics);
+
+    py::class_<AsyncRunner, std::shared_ptr<AsyncRunner>>(m, "AsyncRun")
+        .def("pause", &AsyncRunner::Pause)
+        .def("resume", &AsyncRunner::Resume)
+        .def("stop", &AsyncRunner::Stop)
+        .def("wait", &AsyncRunner::Wait, py::arg("timeout") = -1.0,
+             py::call_guard<py::gil_scoped_release>())
+        .def("is_paused", &AsyncRunner::IsPaused)
+        .def("is_finished", &AsyncRunner::IsFinished)
+        .def("get_time", &AsyncRunner::GetTime)
+        .def("progress", &AsyncRunner::GetProgress)
+        .def("get_dropped_updates", &AsyncRunner::GetDroppedUpdates)
+        // Drain the queue as (time, "scada/tag", value) tuples, at most `max` (0 for all)
+        .def("poll", [](AsyncRunner &runner, size_t max) {
+            py::list updates;
+            std::vector<py::object> names; // By tag id, to only look each name up once
+            TagUpdate update;
+
+            while ((max == 0 || updates.size() < max) && runner.Poll(update))
+            {
+                if (update.tag >= names.size())
+                    names.resize(update.tag + 1);
+
+                if (!names[update.tag])
+                    names[update.tag] = py::str(runner.GetTagName(update.tag));
+
+                updates.append(py::make_tuple(update.time, names[update.tag], update.value));
+            }
+
+            return updates;
+        }, py::arg("max") = 0);
+
+    m.def("run_async", [](double time, const std::vector<ns3::Ptr<ScadaApplication>> &watch, size_t queueSize) {
+        // Joining the simulation thread while holding the GIL would deadlock if it waits
+        // for it in a trampoline, so the GIL is released to destroy the runner
+        std::shared_ptr<AsyncRunner> runner(new AsyncRunner(time, queueSize), [](AsyncRunner *r) {
+            if (PyGILState_Check())
+            {
+                py::gil_scoped_release release;
+                delete r;
+            }
+            else
+            {
+                delete r;
+            }
+        });
+
+        for (const auto &scada : watch)
+            runner->Watch(scada);
+
+        runner->Start();
+        return runner;
+    }, py::arg("time") = 20.0, py::arg("watch") = std::vector<ns3::Ptr<ScadaApplication>>(),
+       py::arg("queue_size") = 65536);
+
+    m.def("enable_profiler", &Profiler::Enable, py::arg("path") = "tinyics.folded");
+
+    m.def("open_stats", &StatsPublisher::Open, py::arg("name") = "/tinyics", py::arg("period") = 100);
+
+    m.def("watch_stats", &StatsPublisher::Watch);
+
+    m.def("close_stats", &StatsPublisher::Close, py::arg("unlink") = true);
+
+    py::class_<Scenario>(m, "Scenario")
+        .def_static("load", py::overload_cast<const std::string &>(&Scenario::Load))
+        .def("run", &Scenario::Run, py::call_guard<py::gil_scoped_release>())
+        .def("get_duration", &Scenario::GetDuration)
+        .def("get_plc", &Scenario::GetPlc)
+        .def("get_scada", &Scenario::GetScada);
+
+    m.def("save_snapshot", &SimulationSnapshot::Save);
+
+    m.def("load_snapshot", &SimulationSnapshot::Load);
+
+    m.def("schedule_snapshot", &SimulationSnapshot::ScheduleSave, py::arg("time"), py::arg("path"));
+
     // TODO: Can this be done internally when calling get_analog_state() ?
-    m.def("scale_word_to_range", &DenormalizeU16InRange);
+    m.def("scale_word_to_range", &DenormalizeU16InRange, py::arg("value"), py::arg("min"),
+          py::arg("max"), py::arg("full_scale") = std::numeric_limits<uint16_t>::max());
 }
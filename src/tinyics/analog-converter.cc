@@ -0,0 +1,139 @@
+#include "analog-converter.h"
+
+#include "ns3/fatal-error.h"
+
+namespace
+{
+
+/// Saturate the scaled value and classify it, NaN fails both comparisons
+inline uint16_t
+Saturate(double scaled, double fullScale, AnalogRange &range)
+{
+    range = !(scaled >= 0) ? UnderRange : (scaled > fullScale ? OverRange : InRange);
+
+    scaled = scaled > 0 ? scaled : 0;
+    scaled = scaled < fullScale ? scaled : fullScale;
+
+    return static_cast<uint16_t>(scaled);
+}
+
+} // namespace
+
+AnalogConverter::AnalogConverter(double min, double max, uint8_t resolution)
+    : m_Min(min),
+      m_Max(max),
+      m_Resolution(resolution)
+{
+    if (!(min < max))
+        NS_FATAL_ERROR("Invalid analog range [" << min << ", " << max << "]");
+
+    if (resolution == 0 || resolution > 16)
+        NS_FATAL_ERROR("Invalid analog resolution '" << (int)resolution << "' bits");
+
+    Update();
+}
+
+void
+AnalogConverter::SetRange(double min, double max)
+{
+    if (!(min < max))
+        NS_FATAL_ERROR("Invalid analog range [" << min << ", " << max << "]");
+
+    m_Min = min;
+    m_Max = max;
+
+    Update();
+}
+
+void
+AnalogConverter::SetResolution(uint8_t bits)
+{
+    if (bits == 0 || bits > 16)
+        NS_FATAL_ERROR("Invalid analog resolution '" << (int)bits << "' bits");
+
+    m_Resolution = bits;
+
+    Update();
+}
+
+uint8_t
+AnalogConverter::GetResolution() const
+{
+    return m_Resolution;
+}
+
+uint16_t
+AnalogConverter::GetFullScale() const
+{
+    return static_cast<uint16_t>(m_FullScale);
+}
+
+uint16_t
+AnalogConverter::ToCounts(double value, AnalogRange *range) const
+{
+    AnalogRange result;
+    uint16_t counts = Saturate(value * m_Scale + m_Offset, m_FullScale, result);
+
+    if (range)
+        *range = result;
+
+    return counts;
+}
+
+double
+AnalogConverter::ToValue(uint16_t counts) const
+{
+    return m_Min + counts * m_Step;
+}
+
+size_t
+AnalogConverter::ToCounts(const double *values,
+                          uint16_t *counts,
+                          size_t num,
+                          AnalogRange *ranges) const
+{
+    // Keep the loops free of calls and of the optional output, so they vectorize
+    double scale = m_Scale;
+    double offset = m_Offset;
+    double fullScale = m_FullScale;
+    size_t outOfRange = 0;
+
+    if (ranges)
+    {
+        for (size_t i = 0; i < num; i++)
+        {
+            counts[i] = Saturate(values[i] * scale + offset, fullScale, ranges[i]);
+            outOfRange += ranges[i] != InRange;
+        }
+
+        return outOfRange;
+    }
+
+    for (size_t i = 0; i < num; i++)
+    {
+        AnalogRange range;
+        counts[i] = Saturate(values[i] * scale + offset, fullScale, range);
+        outOfRange += range != InRange;
+    }
+
+    return outOfRange;
+}
+
+void
+AnalogConverter::ToValues(const uint16_t *counts, double *values, size_t num) const
+{
+    double min = m_Min;
+    double step = m_Step;
+
+    for (size_t i = 0; i < num; i++)
+        values[i] = min + counts[i] * step;
+}
+
+void
+AnalogConverter::Update()
+{
+    m_FullScale = (1u << m_Resolution) - 1;
+    m_Scale = m_FullScale / (m_Max - m_Min);
+    m_Offset = -m_Min * m_Scale;
+    m_Step = (m_Max - m_Min) / m_FullScale;
+}
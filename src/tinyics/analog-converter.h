@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Result of converting a value, values outside of the input range are
+ * saturated to the closest end of the scale instead of failing
+ */
+enum AnalogRange : uint8_t
+{
+    InRange = 0,
+    UnderRange = 1,
+    OverRange = 2,
+};
+
+/*
+ * Linear conversion between engineering values and register counts
+ *
+ * Simulates an ADC (and the DAC going the other way) with a configurable
+ * resolution, the input range [min, max] maps to [0, 2^resolution - 1].
+ * The scale factors are computed once when the range or the resolution
+ * change, so each conversion is a single multiply-add and a clamp. The
+ * batch versions run the same branch-free kernel over whole arrays, which
+ * the compiler vectorizes.
+ */
+class AnalogConverter
+{
+public:
+    AnalogConverter(double min, double max, uint8_t resolution = 16);
+
+    void SetRange(double min, double max);
+
+    /*
+     * Set the amount of bits of the converter (1-16)
+     */
+    void SetResolution(uint8_t bits);
+
+    uint8_t GetResolution() const;
+
+    /*
+     * Largest count the converter produces
+     */
+    uint16_t GetFullScale() const;
+
+    /*
+     * Convert an engineering value into counts, the counts saturate when
+     * the value is out of range (NaN is treated as under range)
+     */
+    uint16_t ToCounts(double value, AnalogRange *range = nullptr) const;
+
+    /*
+     * Convert counts back into an engineering value
+     */
+    double ToValue(uint16_t counts) const;
+
+    /*
+     * Convert `num` values into counts, if `ranges` is not null it receives
+     * the AnalogRange of every value
+     *
+     * returns the amount of values that were out of range
+     */
+    size_t ToCounts(const double *values,
+                    uint16_t *counts,
+                    size_t num,
+                    AnalogRange *ranges = nullptr) const;
+
+    /*
+     * Convert `num` counts back into engineering values
+     */
+    void ToValues(const uint16_t *counts, double *values, size_t num) const;
+
+private:
+    void Update();
+
+    double m_Min;
+    double m_Max;
+    uint8_t m_Resolution;
+
+    double m_FullScale; //!< Largest count, as a double for the kernels
+    double m_Scale;     //!< Counts per engineering unit
+    double m_Offset;    //!< Counts at an engineering value of 0
+    double m_Step;      //!< Engineering units per count
+};
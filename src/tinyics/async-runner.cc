@@ -0,0 +1,252 @@
+#include "async-runner.h"
+
+#include "simulation-runner.h"
+
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <chrono>
+
+std::atomic<bool> AsyncRunner::s_Running{false};
+
+AsyncRunner::AsyncRunner(double time, size_t queueSize)
+    : m_Duration(time),
+      m_Queue(queueSize)
+{
+    if (time <= 0)
+        NS_FATAL_ERROR("The simulation time should be greater than zero");
+}
+
+AsyncRunner::~AsyncRunner()
+{
+    if (m_Thread.joinable())
+    {
+        Stop();
+        Wait();
+    }
+
+    // The SCADAs outlive the runner, give them back their own callbacks
+    for (const ns3::Ptr<ScadaApplication> &scada : m_Watched)
+    {
+        ScadaApplication::VarsCallback &previous = m_Chained[scada->GetName()];
+
+        if (auto historian = ns3::DynamicCast<Historian>(scada))
+            historian->SetRecordCallback(previous);
+        else
+            scada->SetChangeCallback(previous);
+    }
+}
+
+void
+AsyncRunner::Watch(ns3::Ptr<ScadaApplication> scada)
+{
+    if (m_Thread.joinable() || m_Finished)
+        NS_FATAL_ERROR("SCADAs must be watched before the simulation starts");
+
+    if (m_Chained.find(scada->GetName()) != m_Chained.end())
+        NS_FATAL_ERROR("A SCADA named '" << scada->GetName() << "' is already watched");
+
+    // Historians stream what they record, other SCADAs what changed
+    if (auto historian = ns3::DynamicCast<Historian>(scada))
+    {
+        m_Chained[scada->GetName()] = historian->GetRecordCallback();
+        historian->SetRecordCallback(ns3::MakeCallback(&AsyncRunner::Stream, this));
+    }
+    else
+    {
+        m_Chained[scada->GetName()] = scada->GetChangeCallback();
+        scada->SetChangeCallback(ns3::MakeCallback(&AsyncRunner::Stream, this));
+    }
+
+    m_Watched.push_back(scada);
+}
+
+void
+AsyncRunner::Start()
+{
+    if (m_Thread.joinable() || m_Finished)
+        NS_FATAL_ERROR("The simulation was already started");
+
+    if (s_Running.exchange(true))
+        NS_FATAL_ERROR("Another simulation is already running");
+
+    ns3::Simulator::ScheduleNow(&AsyncRunner::Control, this);
+
+    m_Thread = std::thread(&AsyncRunner::Run, this);
+}
+
+void
+AsyncRunner::Run()
+{
+    SimulationRunner::Run(m_Duration);
+
+    m_Time.store(SimulationRunner::GetMetrics().simulatedTime);
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Finished = true;
+    }
+
+    m_FinishedCv.notify_all();
+    s_Running = false;
+}
+
+void
+AsyncRunner::Control()
+{
+    m_Time.store(ns3::Simulator::Now().GetSeconds(), std::memory_order_relaxed);
+
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        if (m_Paused && !m_StopRequested)
+        {
+            auto start = SimulationRunner::Clock::now();
+            m_ResumeCv.wait(lock, [this]() { return !m_Paused || m_StopRequested; });
+
+            // Don't try to catch up with the time spent paused
+            SimulationRunner::Discount(SimulationRunner::Clock::now() - start);
+        }
+    }
+
+    if (m_StopRequested)
+    {
+        ns3::Simulator::Stop();
+        return;
+    }
+
+    ns3::Simulator::Schedule(ns3::MilliSeconds(s_ControlInterval), &AsyncRunner::Control, this);
+}
+
+void
+AsyncRunner::Pause()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Paused = true;
+}
+
+void
+AsyncRunner::Resume()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Paused = false;
+    }
+
+    m_ResumeCv.notify_all();
+}
+
+void
+AsyncRunner::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_StopRequested = true;
+    }
+
+    m_ResumeCv.notify_all();
+}
+
+bool
+AsyncRunner::Wait(double timeout)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    // Never started
+    if (!m_Thread.joinable())
+        return m_Finished;
+
+    auto finished = [this]() { return m_Finished.load(); };
+
+    if (timeout < 0)
+        m_FinishedCv.wait(lock, finished);
+    else if (!m_FinishedCv.wait_for(lock, std::chrono::duration<double>(timeout), finished))
+        return false;
+
+    m_Thread.join();
+    return true;
+}
+
+bool
+AsyncRunner::IsPaused() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Paused;
+}
+
+bool
+AsyncRunner::IsFinished() const
+{
+    return m_Finished;
+}
+
+double
+AsyncRunner::GetTime() const
+{
+    return m_Time.load(std::memory_order_relaxed);
+}
+
+double
+AsyncRunner::GetProgress() const
+{
+    return std::min(1.0, GetTime() / m_Duration);
+}
+
+bool
+AsyncRunner::Poll(TagUpdate &update)
+{
+    return m_Queue.Pop(update);
+}
+
+std::string
+AsyncRunner::GetTagName(uint32_t tag) const
+{
+    std::lock_guard<std::mutex> lock(m_NamesMutex);
+
+    if (tag >= m_TagNames.size())
+        NS_FATAL_ERROR("Unknown tag " << tag);
+
+    return m_TagNames[tag];
+}
+
+uint64_t
+AsyncRunner::GetDroppedUpdates() const
+{
+    return m_Dropped.load(std::memory_order_relaxed);
+}
+
+void
+AsyncRunner::Stream(const std::string &source, const std::map<std::string, Var> &vars)
+{
+    // The callback the SCADA had before watching it runs first
+    auto chained = m_Chained.find(source);
+    if (chained != m_Chained.end() && !chained->second.IsNull())
+        chained->second(source, vars);
+
+    double now = ns3::Simulator::Now().GetSeconds();
+
+    for (const auto &[name, var] : vars)
+    {
+        if (!m_Queue.Push({now, GetTagId(source, name), var.GetValue()}))
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint32_t
+AsyncRunner::GetTagId(const std::string &source, const std::string &name)
+{
+    std::string key = source + '/' + name;
+
+    auto it = m_TagIds.find(key);
+    if (it != m_TagIds.end())
+        return it->second;
+
+    // The name must be readable before the first update with the id is pushed
+    std::lock_guard<std::mutex> lock(m_NamesMutex);
+
+    uint32_t id = m_TagNames.size();
+    m_TagNames.push_back(key);
+    m_TagIds.emplace(std::move(key), id);
+
+    return id;
+}
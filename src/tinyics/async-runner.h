@@ -0,0 +1,133 @@
+#pragma once
+
+#include "historian.h"
+#include "spsc-queue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+/// A variable of a watched SCADA at a given simulated time
+struct TagUpdate
+{
+    double time;
+    uint32_t tag; //!< See AsyncRunner::GetTagName
+    uint16_t value;
+};
+
+/**
+ * Runs the simulation on a background thread.
+ *
+ * The simulation runs with SimulationRunner (same run modes and metrics)
+ * while the thread that started it stays free, e.g. to plot or serve a
+ * dashboard. The variables of the watched SCADAs are streamed to it through
+ * a lock-free single producer single consumer queue: every change notified
+ * by a SCADA and every sample recorded by a Historian becomes a TagUpdate.
+ * When the consumer falls behind and the queue fills up the updates are
+ * dropped and counted, the simulation never waits for it. Callbacks the
+ * SCADAs already had keep being called, and are restored by the destructor.
+ *
+ * A control event every s_ControlInterval simulated milliseconds publishes
+ * the progress and applies pause and stop requests. Paused time is left out
+ * of the pacing.
+ *
+ * Only one simulation can run at a time, and nothing else may touch the
+ * simulator (or the applications) from other threads while it runs.
+ */
+class AsyncRunner
+{
+public:
+    /// \param queueSize capacity of the update queue (rounded up to a power of two)
+    AsyncRunner(double time, size_t queueSize = 65536);
+
+    /// Stops the simulation if still running and waits for it
+    ~AsyncRunner();
+
+    AsyncRunner(const AsyncRunner &) = delete;
+    AsyncRunner &operator=(const AsyncRunner &) = delete;
+
+    /**
+     * Stream the variables of the SCADA (or the samples of the historian),
+     * before starting. The SCADAs are told apart by name.
+     */
+    void Watch(ns3::Ptr<ScadaApplication> scada);
+
+    /// Start running on the background thread
+    void Start();
+
+    /// Stop at the next control event
+    void Pause();
+
+    void Resume();
+
+    /// End the simulation at the next control event (the simulation is destroyed)
+    void Stop();
+
+    /**
+     * Wait for the simulation to finish
+     *
+     * \param timeout seconds to wait at most, negative to wait until it finishes
+     * \returns whether it finished
+     */
+    bool Wait(double timeout = -1);
+
+    bool IsPaused() const;
+
+    bool IsFinished() const;
+
+    /// Simulated seconds elapsed, as of the last control event
+    double GetTime() const;
+
+    /// Fraction of the simulation done (0-1)
+    double GetProgress() const;
+
+    /// Take the next update, false if there's none. Call from a single consumer thread
+    bool Poll(TagUpdate &update);
+
+    /// Name of a tag, "<scada>/<variable>"
+    std::string GetTagName(uint32_t tag) const;
+
+    /// Amount of updates dropped because the queue was full
+    uint64_t GetDroppedUpdates() const;
+
+private:
+    static constexpr uint64_t s_ControlInterval = 10; //!< Simulated milliseconds
+
+    /// Thread body
+    void Run();
+
+    /// Publish the progress, wait while paused and stop if requested, reschedules itself
+    void Control();
+
+    /// Push the variables to the queue
+    void Stream(const std::string &source, const std::map<std::string, Var> &vars);
+
+    /// Id of the tag, assigned the first time it is seen
+    uint32_t GetTagId(const std::string &source, const std::string &name);
+
+    static std::atomic<bool> s_Running; //!< There can only be one simulation
+
+    double m_Duration;
+    std::thread m_Thread;
+    std::vector<ns3::Ptr<ScadaApplication>> m_Watched;
+
+    /// Callback each watched SCADA had before, by name
+    std::unordered_map<std::string, ScadaApplication::VarsCallback> m_Chained;
+
+    SpscQueue<TagUpdate> m_Queue;
+    std::atomic<uint64_t> m_Dropped{0};
+
+    std::unordered_map<std::string, uint32_t> m_TagIds; //!< Only used by the simulation thread
+    std::vector<std::string> m_TagNames;               //!< Guarded by m_NamesMutex
+    mutable std::mutex m_NamesMutex;
+
+    std::atomic<double> m_Time{0};
+    std::atomic<bool> m_StopRequested{false};
+    std::atomic<bool> m_Finished{false};
+    bool m_Paused = false; //!< Guarded by m_Mutex
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_ResumeCv;
+    std::condition_variable m_FinishedCv;
+};
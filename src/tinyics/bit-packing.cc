@@ -0,0 +1,98 @@
+#include "bit-packing.h"
+
+#include <cstring>
+
+// Bits moved per step, a 64 bit word always holds them after shifting
+// out the (up to 7) leading bits of an unaligned offset
+#define BP_STEP_BITS 56
+
+namespace
+{
+
+/// Load `size` (at most 8) bytes as a little endian word
+inline uint64_t
+LoadLE(const uint8_t *bytes, uint32_t size)
+{
+    uint64_t word = 0;
+
+    if (size == 8)
+    {
+        memcpy(&word, bytes, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        return word;
+    }
+
+    for (uint32_t i = 0; i < size; i++)
+        word |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+
+    return word;
+}
+
+/// Store the `size` (at most 8) lower bytes of the word in little endian
+inline void
+StoreLE(uint8_t *bytes, uint32_t size, uint64_t word)
+{
+    if (size == 8)
+    {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        memcpy(bytes, &word, 8);
+        return;
+    }
+
+    for (uint32_t i = 0; i < size; i++)
+        bytes[i] = static_cast<uint8_t>(word >> (8 * i));
+}
+
+} // namespace
+
+void
+CopyBits(const uint8_t *src, uint32_t srcOffset, uint8_t *dst, uint32_t dstOffset, uint32_t count)
+{
+    // Byte aligned on both sides, copy whole bytes and merge the tail
+    if ((srcOffset & 7) == 0 && (dstOffset & 7) == 0)
+    {
+        src += srcOffset >> 3;
+        dst += dstOffset >> 3;
+
+        memcpy(dst, src, count >> 3);
+
+        uint32_t tail = count & 7;
+        if (tail)
+        {
+            uint8_t mask = (1 << tail) - 1;
+            uint32_t last = count >> 3;
+
+            dst[last] = (dst[last] & ~mask) | (src[last] & mask);
+        }
+
+        return;
+    }
+
+    while (count > 0)
+    {
+        uint32_t bits = count < BP_STEP_BITS ? count : BP_STEP_BITS;
+        uint64_t mask = (static_cast<uint64_t>(1) << bits) - 1;
+
+        // Read the bits from the source, right aligned
+        uint32_t srcShift = srcOffset & 7;
+        uint32_t srcBytes = (srcShift + bits + 7) >> 3;
+        uint64_t value = (LoadLE(src + (srcOffset >> 3), srcBytes) >> srcShift) & mask;
+
+        // Merge them into the destination bytes they cover
+        uint32_t dstShift = dstOffset & 7;
+        uint32_t dstBytes = (dstShift + bits + 7) >> 3;
+        uint8_t *out = dst + (dstOffset >> 3);
+
+        uint64_t word = LoadLE(out, dstBytes);
+        word = (word & ~(mask << dstShift)) | (value << dstShift);
+        StoreLE(out, dstBytes, word);
+
+        srcOffset += bits;
+        dstOffset += bits;
+        count -= bits;
+    }
+}
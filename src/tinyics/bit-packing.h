@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Copy a range of bits between two packed bit buffers
+ *
+ * Bits are numbered LSB first inside each byte, which is how Modbus packs
+ * coils and discrete inputs (bit 0 of the first data byte is the first
+ * coil). The source and destination ranges may start at any bit offset,
+ * the copy moves up to 56 bits per step using 64 bit loads and stores.
+ * Bits of the destination outside of the range are left untouched.
+ */
+void CopyBits(const uint8_t *src,
+              uint32_t srcOffset,
+              uint8_t *dst,
+              uint32_t dstOffset,
+              uint32_t count);
+
+/*
+ * Get the bit at the given position of a packed bit buffer
+ */
+inline bool
+GetPackedBit(const uint8_t *bits, uint32_t pos)
+{
+    return (bits[pos >> 3] >> (pos & 7)) & 1;
+}
+
+/*
+ * Amount of bytes needed to pack the given amount of bits
+ */
+inline uint32_t
+PackedSize(uint32_t count)
+{
+    return (count + 7) >> 3;
+}
@@ -0,0 +1,353 @@
+#include "continuous-process.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+// Smallest step before the adaptive integrator gives up
+#define CP_MIN_STEP 1e-12
+
+namespace
+{
+
+struct RegisteredKernel
+{
+    ContinuousProcess::Kernel kernel;
+    size_t parameters; //!< Amount of parameters the kernel reads
+};
+
+std::unordered_map<std::string, RegisteredKernel> &
+GetKernels()
+{
+    static std::unordered_map<std::string, RegisteredKernel> kernels;
+    return kernels;
+}
+
+const RegisteredKernel &
+FindKernel(const std::string &name)
+{
+    auto kernel = GetKernels().find(name);
+
+    if (kernel == GetKernels().end())
+        NS_FATAL_ERROR("Unknown process kernel '" << name << "'");
+
+    return kernel->second;
+}
+
+/// Dormand-Prince 5(4) tableau
+constexpr double DP_C[7] = {0, 1.0 / 5, 3.0 / 10, 4.0 / 5, 8.0 / 9, 1, 1};
+
+constexpr double DP_A[7][6] = {
+    {},
+    {1.0 / 5},
+    {3.0 / 40, 9.0 / 40},
+    {44.0 / 45, -56.0 / 15, 32.0 / 9},
+    {19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729},
+    {9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656},
+    {35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84},
+};
+
+/// Difference between the 5th and 4th order weights
+constexpr double DP_E[7] = {71.0 / 57600,
+                            0,
+                            -71.0 / 16695,
+                            71.0 / 1920,
+                            -17253.0 / 339200,
+                            22.0 / 525,
+                            -1.0 / 40};
+
+} // namespace
+
+ContinuousProcess::ContinuousProcess(size_t dimension, Integrator integrator)
+    : m_Integrator(integrator),
+      m_State(dimension),
+      m_K(7 * dimension),
+      m_Temp(dimension),
+      m_Next(dimension)
+{
+}
+
+void
+ContinuousProcess::RegisterKernel(const std::string &name, Kernel kernel, size_t parameters)
+{
+    GetKernels()[name] = {std::move(kernel), parameters};
+}
+
+size_t
+ContinuousProcess::GetKernelParameters(const std::string &name)
+{
+    return FindKernel(name).parameters;
+}
+
+void
+ContinuousProcess::SetKernel(const std::string &name)
+{
+    m_Kernel = FindKernel(name).kernel;
+}
+
+void
+ContinuousProcess::SetKernel(Kernel kernel)
+{
+    m_Kernel = std::move(kernel);
+}
+
+void
+ContinuousProcess::SetParameters(const std::vector<double> &parameters)
+{
+    m_Parameters = parameters;
+}
+
+void
+ContinuousProcess::SetIntegrator(Integrator integrator)
+{
+    m_Integrator = integrator;
+}
+
+void
+ContinuousProcess::SetMaxStep(double step)
+{
+    if (!(step > 0))
+        NS_FATAL_ERROR("The integration step must be positive, got " << step);
+
+    m_MaxStep = step;
+}
+
+void
+ContinuousProcess::SetTolerance(double absolute, double relative)
+{
+    m_AbsTol = absolute;
+    m_RelTol = relative;
+}
+
+const std::vector<double> &
+ContinuousProcess::GetState() const
+{
+    return m_State;
+}
+
+void
+ContinuousProcess::SetState(const std::vector<double> &state)
+{
+    if (state.size() != m_State.size())
+        NS_FATAL_ERROR("Expected a state of " << m_State.size() << " values, got "
+                                              << state.size());
+
+    m_State = state;
+}
+
+double
+ContinuousProcess::GetTime() const
+{
+    return m_Time;
+}
+
+uint64_t
+ContinuousProcess::GetStepCount() const
+{
+    return m_Steps;
+}
+
+uint64_t
+ContinuousProcess::GetRejectedCount() const
+{
+    return m_Rejected;
+}
+
+void
+ContinuousProcess::UpdateProcess(PlcState *measurements, const PlcState *input)
+{
+    double now = ns3::Simulator::Now().GetSeconds();
+
+    if (now > m_Time && !m_State.empty())
+    {
+        if (m_Integrator == Integrator::RK4)
+            IntegrateRK4(now, input);
+        else
+            IntegrateDormandPrince(now, input);
+    }
+
+    m_Time = now;
+
+    Measure(m_State, measurements);
+}
+
+std::string
+ContinuousProcess::Serialize() const
+{
+    SnapshotWriter writer;
+
+    // The time isn't stored, the state is restored at the start of a new run
+    writer.Write(m_Step);
+    writer.Write<uint32_t>(m_State.size());
+
+    for (double value : m_State)
+        writer.Write(value);
+
+    return writer.GetBuffer();
+}
+
+void
+ContinuousProcess::Deserialize(const std::string &state)
+{
+    SnapshotReader reader(state);
+
+    // Integrate from the time of the restore, not the one of the snapshot
+    m_Time = ns3::Simulator::Now().GetSeconds();
+    m_Step = reader.Read<double>();
+
+    if (reader.Read<uint32_t>() != m_State.size())
+        NS_FATAL_ERROR("Snapshot state doesn't match the dimension of the process");
+
+    for (double &value : m_State)
+        value = reader.Read<double>();
+}
+
+void
+ContinuousProcess::Derivatives(double t, const double *x, double *dxdt, const PlcState *input)
+{
+    if (!m_Kernel)
+        NS_FATAL_ERROR("Continuous process without a kernel");
+
+    m_Kernel(t, x, dxdt, input, m_Parameters.data());
+}
+
+void
+ContinuousProcess::IntegrateRK4(double end, const PlcState *input)
+{
+    size_t n = m_State.size();
+    double *x = m_State.data();
+    double *k1 = m_K.data();
+    double *k2 = k1 + n;
+    double *k3 = k2 + n;
+    double *k4 = k3 + n;
+    double *temp = m_Temp.data();
+
+    double t = m_Time;
+
+    // Split the interval in equal steps no longer than the maximum, so
+    // rounding doesn't leave a tiny step at the end
+    auto steps = static_cast<uint64_t>(std::ceil((end - t) / m_MaxStep * (1 - 1e-9)));
+    double h = (end - t) / std::max<uint64_t>(steps, 1);
+
+    for (uint64_t step = 0; step < std::max<uint64_t>(steps, 1); step++)
+    {
+        Derivatives(t, x, k1, input);
+
+        for (size_t i = 0; i < n; i++)
+            temp[i] = x[i] + h / 2 * k1[i];
+        Derivatives(t + h / 2, temp, k2, input);
+
+        for (size_t i = 0; i < n; i++)
+            temp[i] = x[i] + h / 2 * k2[i];
+        Derivatives(t + h / 2, temp, k3, input);
+
+        for (size_t i = 0; i < n; i++)
+            temp[i] = x[i] + h * k3[i];
+        Derivatives(t + h, temp, k4, input);
+
+        for (size_t i = 0; i < n; i++)
+            x[i] += h / 6 * (k1[i] + 2 * k2[i] + 2 * k3[i] + k4[i]);
+
+        t += h;
+        m_Steps++;
+    }
+}
+
+void
+ContinuousProcess::IntegrateDormandPrince(double end, const PlcState *input)
+{
+    size_t n = m_State.size();
+    double *x = m_State.data();
+    double *temp = m_Temp.data();
+    double *next = m_Next.data();
+
+    auto k = [this, n](int stage) { return m_K.data() + stage * n; };
+
+    double t = m_Time;
+    double h = m_Step > 0 ? m_Step : m_MaxStep;
+
+    // The inputs may have changed since the last update, so the first stage
+    // is recomputed instead of reusing the last one of the previous update
+    Derivatives(t, x, k(0), input);
+
+    while (t < end)
+    {
+        h = std::min({h, m_MaxStep, end - t});
+        bool last = h >= end - t;
+
+        for (int s = 1; s < 7; s++)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                double sum = 0;
+                for (int j = 0; j < s; j++)
+                    sum += DP_A[s][j] * k(j)[i];
+
+                temp[i] = x[i] + h * sum;
+            }
+
+            Derivatives(t + DP_C[s] * h, temp, k(s), input);
+        }
+
+        // The last stage is evaluated at the 5th order solution
+        std::copy(temp, temp + n, next);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            double error = 0;
+            for (int s = 0; s < 7; s++)
+                error += DP_E[s] * k(s)[i];
+
+            temp[i] = h * error;
+        }
+
+        double error = ErrorNorm(temp, next);
+
+        // Standard controller, grow at most 5x and shrink at most 5x per step
+        double factor = error > 0 ? 0.9 * std::pow(error, -0.2) : 5;
+        factor = std::clamp(factor, 0.2, 5.0);
+
+        if (error <= 1)
+        {
+            t = last ? end : t + h;
+            std::copy(next, next + n, x);
+
+            // First same as last, the last stage is the derivative at the new state
+            std::copy(k(6), k(6) + n, k(0));
+
+            m_Steps++;
+
+            // A step shortened to land on the update time doesn't say much
+            // about the step the dynamics allow, keep the previous suggestion
+            if (!last || m_Step == 0)
+                m_Step = h * factor;
+
+            h *= factor;
+        }
+        else
+        {
+            m_Rejected++;
+            h *= std::min(factor, 1.0);
+
+            if (h < CP_MIN_STEP)
+                NS_FATAL_ERROR("Integration step underflow at t = " << t << "s, the "
+                               "process is too stiff for the requested tolerance");
+        }
+    }
+}
+
+double
+ContinuousProcess::ErrorNorm(const double *error, const double *next) const
+{
+    size_t n = m_State.size();
+    double sum = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double scale = m_AbsTol + m_RelTol * std::max(std::abs(m_State[i]), std::abs(next[i]));
+        double ratio = error[i] / scale;
+        sum += ratio * ratio;
+    }
+
+    return std::sqrt(sum / n);
+}
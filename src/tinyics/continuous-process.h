@@ -0,0 +1,138 @@
+#pragma once
+
+#include "industrial-process.h"
+
+#include <functional>
+#include <vector>
+
+/**
+ * Numerical method used to advance a ContinuousProcess
+ */
+enum class Integrator
+{
+    RK4,           //!< Classic Runge-Kutta, fixed step
+    DormandPrince, //!< Runge-Kutta 5(4) with adaptive step and error control
+};
+
+/**
+ * An Industrial Process described by a system of ODEs
+ *
+ * The process declares a state vector and the derivative of each of its
+ * components, dx/dt = f(t, x, input, parameters). On each plant update the
+ * state is integrated from the time of the previous update to the current
+ * simulation time, sub-stepping as needed, so the accuracy doesn't depend
+ * on the refresh rate of the plant. The PLC outputs are held constant
+ * between two updates.
+ *
+ * The derivative is either overridden in a subclass (C++) or taken from a
+ * kernel registered by name, so Python processes can use native kernels
+ * without calling back into Python on every step. After integrating,
+ * Measure is called to update the measurements of the PLC.
+ */
+class ContinuousProcess : public IndustrialProcess
+{
+public:
+    /// Derivative kernel, writes dx/dt for the state `x` at time `t` (in seconds)
+    using Kernel = std::function<void(double t,
+                                      const double *x,
+                                      double *dxdt,
+                                      const PlcState *input,
+                                      const double *parameters)>;
+
+    /**
+     * Create a process with a state of `dimension` variables, all starting at 0
+     */
+    ContinuousProcess(size_t dimension, Integrator integrator = Integrator::RK4);
+
+    /**
+     * Make a kernel available to every process by name, `parameters` is the
+     * amount of parameters it reads (processes must set at least that many)
+     */
+    static void RegisterKernel(const std::string &name, Kernel kernel, size_t parameters = 0);
+
+    /// Amount of parameters the registered kernel reads
+    static size_t GetKernelParameters(const std::string &name);
+
+    /// Use a registered kernel as the derivative of the process
+    void SetKernel(const std::string &name);
+
+    /// Use the given function as the derivative of the process
+    void SetKernel(Kernel kernel);
+
+    /// Constant parameters passed to the kernel
+    void SetParameters(const std::vector<double> &parameters);
+
+    void SetIntegrator(Integrator integrator);
+
+    /**
+     * Largest step taken by the integrator (in seconds)
+     *
+     * RK4 splits each update in equal steps no longer than it,
+     * Dormand-Prince uses it as the upper bound of its adaptive step.
+     */
+    void SetMaxStep(double step);
+
+    /// Error tolerances of the adaptive integrator
+    void SetTolerance(double absolute, double relative);
+
+    const std::vector<double> &GetState() const;
+
+    void SetState(const std::vector<double> &state);
+
+    /// Time (in seconds) the state corresponds to
+    double GetTime() const;
+
+    /// Steps taken since the start (accepted ones for Dormand-Prince)
+    uint64_t GetStepCount() const;
+
+    /// Steps of Dormand-Prince rejected because of their error
+    uint64_t GetRejectedCount() const;
+
+    /// Integrates the state up to now and updates the measurements
+    void UpdateProcess(PlcState *measurements, const PlcState *input) final;
+
+    /**
+     * Set the measurements of the PLC from the current state
+     */
+    virtual void Measure(const std::vector<double> &state, PlcState *measurements) = 0;
+
+    std::string Serialize() const override;
+
+    void Deserialize(const std::string &state) override;
+
+protected:
+    /**
+     * Compute the derivative of the state, by default calls the kernel
+     */
+    virtual void Derivatives(double t, const double *x, double *dxdt, const PlcState *input);
+
+private:
+    /// Advance the state from m_Time to `end` with RK4
+    void IntegrateRK4(double end, const PlcState *input);
+
+    /// Advance the state from m_Time to `end` with Dormand-Prince
+    void IntegrateDormandPrince(double end, const PlcState *input);
+
+    /// Weighted RMS norm of the error estimate of the last step
+    double ErrorNorm(const double *error, const double *next) const;
+
+    Integrator m_Integrator;
+    Kernel m_Kernel;
+    std::vector<double> m_Parameters;
+
+    std::vector<double> m_State;
+    double m_Time = 0;
+
+    double m_MaxStep = 0.01;
+    double m_Step = 0;  //!< Step suggested by the last adaptive step
+    double m_AbsTol = 1e-6;
+    double m_RelTol = 1e-6;
+
+    uint64_t m_Steps = 0;
+    uint64_t m_Rejected = 0;
+
+    // Scratch space, so steps don't allocate
+    std::vector<double> m_K;    //!< Stages, `dimension` values each
+    std::vector<double> m_Temp; //!< State of the current stage
+    std::vector<double> m_Next; //!< Candidate state at the end of the step
+};
@@ -0,0 +1,169 @@
+#include "historian.h"
+
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+/// Simulated seconds to microseconds, clamped so open ranges (e.g. infinity) work
+int64_t
+ToMicroSeconds(double seconds)
+{
+    double us = seconds * 1e6;
+
+    if (us >= static_cast<double>(std::numeric_limits<int64_t>::max()))
+        return std::numeric_limits<int64_t>::max();
+
+    if (us <= static_cast<double>(std::numeric_limits<int64_t>::min()))
+        return std::numeric_limits<int64_t>::min();
+
+    return std::llround(us);
+}
+
+} // namespace
+
+ns3::TypeId
+Historian::GetTypeId()
+{
+    static ns3::TypeId tid =
+        ns3::TypeId("Historian").SetParent<ScadaApplication>().SetGroupName("Applications");
+
+    return tid;
+}
+
+Historian::Historian(const char *name, double rate)
+    : ScadaApplication(name, rate)
+{
+}
+
+void
+Historian::SetRecordOnChange(bool enable)
+{
+    m_RecordOnChange = enable;
+}
+
+void
+Historian::SetRetention(double seconds)
+{
+    m_Retention = ToMicroSeconds(seconds);
+}
+
+void
+Historian::SetMemoryLimit(size_t bytes)
+{
+    m_MemoryLimit = bytes;
+}
+
+void
+Historian::SetRecordCallback(VarsCallback callback)
+{
+    m_RecordCallback = callback;
+}
+
+Historian::VarsCallback
+Historian::GetRecordCallback() const
+{
+    return m_RecordCallback;
+}
+
+void
+Historian::Update(const std::map<std::string, Var> &vars)
+{
+    if (!m_RecordOnChange)
+        Record(vars);
+}
+
+void
+Historian::OnChange(const std::map<std::string, Var> &changed)
+{
+    if (m_RecordOnChange)
+        Record(changed);
+}
+
+void
+Historian::Record(const std::map<std::string, Var> &vars)
+{
+    int64_t now = ns3::Simulator::Now().GetMicroSeconds();
+
+    for (const auto &[name, var] : vars)
+        m_Series[name].Append(now, var.GetValue());
+
+    if (!m_RecordCallback.IsNull())
+        m_RecordCallback(GetName(), vars);
+
+    // Each tag gets an even share of the memory
+    size_t budget = m_MemoryLimit && !m_Series.empty() ? m_MemoryLimit / m_Series.size() : 0;
+
+    for (auto &[name, series] : m_Series)
+    {
+        if (m_Retention > 0)
+            series.DropBefore(now - m_Retention);
+
+        if (budget > 0)
+            series.Trim(budget);
+    }
+}
+
+const TimeSeries &
+Historian::GetSeries(const std::string &tag) const
+{
+    auto it = m_Series.find(tag);
+    if (it == m_Series.end())
+        NS_FATAL_ERROR("No samples of tag '" << tag << "' in historian '" << GetName() << '\'');
+
+    return it->second;
+}
+
+std::vector<TimeSample>
+Historian::Query(const std::string &tag, double start, double end) const
+{
+    return GetSeries(tag).Query(ToMicroSeconds(start), ToMicroSeconds(end));
+}
+
+std::vector<TimeBucket>
+Historian::Downsample(const std::string &tag, double start, double end, double step) const
+{
+    const TimeSeries &series = GetSeries(tag);
+
+    if (step <= 0)
+        NS_FATAL_ERROR("The downsampling step must be greater than zero");
+
+    // Open ranges start at the beginning of the simulation, so buckets are aligned to it
+    return series.Downsample(std::max<int64_t>(ToMicroSeconds(start), 0),
+                             ToMicroSeconds(end),
+                             std::max<int64_t>(ToMicroSeconds(step), 1));
+}
+
+std::vector<std::string>
+Historian::GetTags() const
+{
+    std::vector<std::string> tags;
+    tags.reserve(m_Series.size());
+
+    for (const auto &[name, series] : m_Series)
+        tags.push_back(name);
+
+    return tags;
+}
+
+uint64_t
+Historian::GetSampleCount(const std::string &tag) const
+{
+    auto it = m_Series.find(tag);
+    return it == m_Series.end() ? 0 : it->second.GetCount();
+}
+
+size_t
+Historian::GetMemoryUsage() const
+{
+    size_t memory = 0;
+
+    for (const auto &[name, series] : m_Series)
+        memory += series.GetMemoryUsage();
+
+    return memory;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "scada-application.h"
+#include "time-series.h"
+
+/**
+ * Records the tags read from the PLCs over Modbus.
+ *
+ * A historian is a SCADA without logic: it polls its RTUs like any other
+ * (AddRTU/AddVariable, staggered polling, batching...) and appends every
+ * tag to a compressed TimeSeries, which can be queried by time range or
+ * downsampled while or after the simulation runs.
+ *
+ * By default every tag is recorded on every scan. With SetRecordOnChange
+ * only the tags that moved further than their deadband are, like an
+ * exception based historian.
+ *
+ * Memory is bounded by a retention window and/or a memory limit, past them
+ * the oldest samples are dropped, so long runs keep a fixed footprint.
+ */
+class Historian : public ScadaApplication
+{
+public:
+    static ns3::TypeId GetTypeId();
+
+    Historian(const char *name, double rate = 500);
+
+    /// Only record the tags that changed further than their deadband
+    void SetRecordOnChange(bool enable);
+
+    /// Drop the samples older than the given amount of simulated seconds (0 keeps them all)
+    void SetRetention(double seconds);
+
+    /// Maximum amount of bytes taken by the samples of all the tags (0 for no limit)
+    void SetMemoryLimit(size_t bytes);
+
+    /// Notify the variables recorded, every time they are recorded
+    void SetRecordCallback(VarsCallback callback);
+
+    VarsCallback GetRecordCallback() const;
+
+    /// Samples of the tag between the given simulated times (in seconds, inclusive)
+    std::vector<TimeSample> Query(const std::string &tag, double start, double end) const;
+
+    /// Aggregates of the tag between the given simulated times in buckets of `step` seconds
+    std::vector<TimeBucket> Downsample(const std::string &tag,
+                                       double start,
+                                       double end,
+                                       double step) const;
+
+    std::vector<std::string> GetTags() const;
+
+    /// Amount of samples of the tag currently stored
+    uint64_t GetSampleCount(const std::string &tag) const;
+
+    /// Bytes taken by the samples of all the tags
+    size_t GetMemoryUsage() const;
+
+    /// Records every tag (when not recording on change)
+    void Update(const std::map<std::string, Var> &vars) final;
+
+    /// Records the tags that changed (when recording on change)
+    void OnChange(const std::map<std::string, Var> &changed) final;
+
+private:
+    /// Append the values of the variables at the current time and apply the limits
+    void Record(const std::map<std::string, Var> &vars);
+
+    const TimeSeries &GetSeries(const std::string &tag) const;
+
+    std::map<std::string, TimeSeries> m_Series;
+    bool m_RecordOnChange = false;
+    int64_t m_Retention = 0; //!< Microseconds
+    size_t m_MemoryLimit = 0;
+    VarsCallback m_RecordCallback;
+};
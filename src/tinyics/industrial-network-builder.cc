@@ -1,6 +1,53 @@
 #include "industrial-network-builder.h"
 #include "ns3/names.h"
 
+#include <chrono>
+#include <fstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double
+SecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/// Resident set size of the process in bytes, 0 when it can't be measured
+int64_t
+GetResidentMemory()
+{
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    int64_t size, resident;
+
+    if (statm >> size >> resident)
+        return resident * sysconf(_SC_PAGESIZE);
+#endif
+
+    return 0;
+}
+
+} // namespace
+
+void
+BuildProfile::Print(std::ostream &os) const
+{
+    os << "Built " << nodes << " nodes in " << totalTime << "s (add " << addTime << "s, stack "
+       << stackTime << "s, devices " << deviceTime << "s, addresses " << addressTime << "s)";
+
+    if (memory > 0)
+        os << ", " << memory / 1024 << " KiB (" << memoryPerNode / 1024 << " KiB per node)";
+
+    os << '\n';
+}
+
 IndustrialNetworkBuilder::IndustrialNetworkBuilder(ns3::Ipv4Address network, ns3::Ipv4Mask mask)
 {
     m_csma = ns3::CsmaHelper();
@@ -23,43 +70,101 @@ IndustrialNetworkBuilder::AddToNetwork(ns3::Ptr<IndustrialApplication> app)
         throw std::exception();
     }
 
+    if (m_startMemory < 0)
+        m_startMemory = GetResidentMemory();
+
+    auto start = Clock::now();
+
     ns3::Ptr<ns3::Node> node = ns3::CreateObject<ns3::Node>();
     node->AddApplication(app);
-    ns3::Names::Add(app->GetName(), node);
+
+    if (m_registerNames)
+        ns3::Names::Add(app->GetName(), node);
 
     m_applications.push_back(app);
+    m_nodes.Add(node);
+
+    m_profile.addTime += SecondsSince(start);
+}
+
+void
+IndustrialNetworkBuilder::AddToNetwork(const std::vector<ns3::Ptr<IndustrialApplication>> &apps)
+{
+    Reserve(m_applications.size() + apps.size());
+
+    for (const auto &app : apps)
+        AddToNetwork(app);
+}
+
+void
+IndustrialNetworkBuilder::Reserve(size_t count)
+{
+    m_applications.reserve(count);
+}
+
+void
+IndustrialNetworkBuilder::SetNameRegistration(bool enable)
+{
+    m_registerNames = enable;
+}
+
+void
+IndustrialNetworkBuilder::SetVerbose(bool verbose)
+{
+    m_verbose = verbose;
+}
+
+void
+IndustrialNetworkBuilder::SetLightweightStack(bool enable)
+{
+    m_lightweightStack = enable;
 }
 
 void
 IndustrialNetworkBuilder::BuildNetwork()
 {
-    ns3::NodeContainer nodes = GetAllNodes();
+    auto start = Clock::now();
 
     ns3::InternetStackHelper internet;
-    internet.Install(nodes);
-    ns3::NetDeviceContainer devices = m_csma.Install(nodes);
 
+    // Every node is on the same segment, the connected routes are enough
+    if (m_lightweightStack)
+    {
+        internet.SetIpv6StackInstall(false);
+        internet.SetRoutingHelper(ns3::Ipv4StaticRoutingHelper());
+    }
+
+    internet.Install(m_nodes);
+    m_profile.stackTime = SecondsSince(start);
+
+    auto step = Clock::now();
+    ns3::NetDeviceContainer devices = m_csma.Install(m_nodes);
+    m_profile.deviceTime = SecondsSince(step);
+
+    step = Clock::now();
     ns3::Ipv4InterfaceContainer i = m_ipv4Address.Assign(devices);
 
-    for (int app = 0; app < m_applications.size(); app++)
+    for (size_t app = 0; app < m_applications.size(); app++)
     {
         auto industrialApp = m_applications[app];
         industrialApp->SetAddress(i.GetAddress(app));
 
-        std::clog << industrialApp->GetName() << ": " << industrialApp->GetAddress() << '\n';
+        if (m_verbose)
+            std::clog << industrialApp->GetName() << ": " << industrialApp->GetAddress() << '\n';
     }
-}
 
-ns3::NodeContainer
-IndustrialNetworkBuilder::GetAllNodes()
-{
-    ns3::NodeContainer n;
-    for (int i = 0; i < m_applications.size(); i++)
+    m_profile.addressTime = SecondsSince(step);
+
+    m_profile.nodes = m_nodes.GetN();
+    m_profile.totalTime =
+        m_profile.addTime + m_profile.stackTime + m_profile.deviceTime + m_profile.addressTime;
+
+    int64_t memory = GetResidentMemory();
+    if (memory > 0 && m_startMemory > 0)
     {
-        n.Add(m_applications[i]->GetNode());
+        m_profile.memory = memory - m_startMemory;
+        m_profile.memoryPerNode = m_profile.nodes ? double(m_profile.memory) / m_profile.nodes : 0;
     }
-
-    return n;
 }
 
 void
@@ -68,3 +173,8 @@ IndustrialNetworkBuilder::EnablePcap(std::string filePrefix)
     m_csma.EnablePcapAll(filePrefix);
 }
 
+const BuildProfile &
+IndustrialNetworkBuilder::GetProfile() const
+{
+    return m_profile;
+}
@@ -1,4 +1,7 @@
 #include "industrial-plant.h"
+#include "profiler.h"
+#include "scada-application.h"
+#include "stats-publisher.h"
 
 IndustrialPlant *IndustrialPlant::s_Instance = nullptr;
 
@@ -34,6 +37,78 @@ IndustrialPlant::RegisterProcess(IndustrialProcess *process)
     s_Instance->m_Processes.push_back(process);
 }
 
+void
+IndustrialPlant::RegisterScada(ScadaApplication *scada)
+{
+    InitPlant();
+    s_Instance->m_Scadas.push_back(scada);
+}
+
+void
+IndustrialPlant::Serialize(SnapshotWriter &writer)
+{
+    InitPlant();
+
+    // Each device is stored as a named blob so unknown ones can be skipped
+    writer.Write<uint32_t>(s_Instance->m_Plcs.size());
+    for (auto plc : s_Instance->m_Plcs)
+    {
+        SnapshotWriter device;
+        plc->Serialize(device);
+
+        writer.WriteString(plc->GetName());
+        writer.WriteString(device.GetBuffer());
+    }
+
+    writer.Write<uint32_t>(s_Instance->m_Scadas.size());
+    for (auto scada : s_Instance->m_Scadas)
+    {
+        SnapshotWriter device;
+        scada->Serialize(device);
+
+        writer.WriteString(scada->GetName());
+        writer.WriteString(device.GetBuffer());
+    }
+}
+
+void
+IndustrialPlant::Deserialize(SnapshotReader &reader)
+{
+    InitPlant();
+
+    auto plcCount = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < plcCount; i++)
+    {
+        std::string name = reader.ReadString();
+        SnapshotReader device(reader.ReadString());
+
+        auto plc = std::find_if(s_Instance->m_Plcs.begin(),
+                                s_Instance->m_Plcs.end(),
+                                [&name](PlcApplication *p) { return p->GetName() == name; });
+
+        if (plc != s_Instance->m_Plcs.end())
+            (*plc)->Deserialize(device);
+        else
+            std::clog << "PLC " << name << " from snapshot not found, ignoring it\n";
+    }
+
+    auto scadaCount = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < scadaCount; i++)
+    {
+        std::string name = reader.ReadString();
+        SnapshotReader device(reader.ReadString());
+
+        auto scada = std::find_if(s_Instance->m_Scadas.begin(),
+                                  s_Instance->m_Scadas.end(),
+                                  [&name](ScadaApplication *s) { return s->GetName() == name; });
+
+        if (scada != s_Instance->m_Scadas.end())
+            (*scada)->Deserialize(device);
+        else
+            std::clog << "SCADA " << name << " from snapshot not found, ignoring it\n";
+    }
+}
+
 void
 IndustrialPlant::InitPlant()
 {
@@ -57,8 +132,14 @@ IndustrialPlant::DoUpdate()
     if (!m_Sorted)
         Sort();
 
+    TINYICS_PROFILE_SCOPE("plant", "");
+    StatsTimer timer(StatsPublisher::GetPlantTicks());
+
     for (auto process : m_Processes)
+    {
+        TINYICS_PROFILE_SCOPE("process", "");
         if (process) process->DoUpdate();
+    }
 
     for (auto plc : m_Plcs)
         if (plc) plc->DoUpdate();
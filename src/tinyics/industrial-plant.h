@@ -1,6 +1,9 @@
 #pragma once
 
 #include "plc-application.h"
+#include "snapshot.h"
+
+class ScadaApplication;
 
 /*
  * This class represents the physics of the whole system.
@@ -14,8 +17,16 @@ public:
 
     static void RegisterProcess(IndustrialProcess *process);
 
+    static void RegisterScada(ScadaApplication *scada);
+
     static void SetRefreshRate(uint64_t rate);
 
+    /// Write the state of every PLC (with its process) and SCADA into the snapshot
+    static void Serialize(SnapshotWriter &writer);
+
+    /// Restore the state written by Serialize, devices are matched by name
+    static void Deserialize(SnapshotReader &reader);
+
 private:
     IndustrialPlant() = default;
 
@@ -34,6 +45,7 @@ private:
 
     std::vector<IndustrialProcess*> m_Processes;
     std::vector<PlcApplication*> m_Plcs;
+    std::vector<ScadaApplication*> m_Scadas;
     ns3::Time m_Interval;
     ns3::Time m_Step = ns3::Seconds(0.0);
     bool m_Sorted;
@@ -6,6 +6,8 @@
 
 #include "plc-state.h"
 
+#include <string>
+
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
 
@@ -26,6 +28,22 @@ public:
 
     uint8_t GetPriority() const;
 
+    /**
+     * Get the internal state of the process to store it in a snapshot.
+     *
+     * Is expected to be overwritten by processes that keep state (e.g. their
+     * AnalogSensor values), by default there's nothing to store.
+     */
+    virtual std::string Serialize() const
+    {
+        return std::string();
+    }
+
+    /// Restore the state returned by Serialize
+    virtual void Deserialize(const std::string &state)
+    {
+    }
+
 private:
     PlcState* m_Measurements;
     const PlcState* m_Input;
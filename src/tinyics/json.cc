@@ -0,0 +1,442 @@
+#include "json.h"
+
+#include "ns3/fatal-error.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+const char *
+GetTypeName(JsonValue::Type type)
+{
+    switch (type)
+    {
+    case JsonValue::Type::Null:
+        return "null";
+    case JsonValue::Type::Bool:
+        return "bool";
+    case JsonValue::Type::Number:
+        return "number";
+    case JsonValue::Type::String:
+        return "string";
+    case JsonValue::Type::Array:
+        return "array";
+    case JsonValue::Type::Object:
+        return "object";
+    }
+
+    return "unknown";
+}
+
+} // namespace
+
+/**
+ * Recursive descent parser over the whole document
+ */
+class JsonValue::Parser
+{
+public:
+    Parser(const std::string &text, const std::string &source)
+        : m_Text(text),
+          m_Source(source)
+    {
+    }
+
+    JsonValue ParseDocument()
+    {
+        JsonValue value = ParseValue();
+
+        SkipSpaces();
+        if (m_Pos != m_Text.size())
+            Fail("unexpected data after the end of the document");
+
+        return value;
+    }
+
+private:
+    [[noreturn]] void Fail(const std::string &what) const
+    {
+        NS_FATAL_ERROR(m_Source << ":" << m_Line << ": " << what);
+    }
+
+    void SkipSpaces()
+    {
+        while (m_Pos < m_Text.size())
+        {
+            char c = m_Text[m_Pos];
+
+            if (c == '\n')
+                m_Line++;
+            else if (c != ' ' && c != '\t' && c != '\r')
+                return;
+
+            m_Pos++;
+        }
+    }
+
+    char Peek()
+    {
+        SkipSpaces();
+
+        if (m_Pos == m_Text.size())
+            Fail("unexpected end of the document");
+
+        return m_Text[m_Pos];
+    }
+
+    void Expect(char expected)
+    {
+        if (Peek() != expected)
+            Fail(std::string("expected '") + expected + "'");
+
+        m_Pos++;
+    }
+
+    bool Consume(const char *literal)
+    {
+        size_t size = strlen(literal);
+
+        if (m_Text.compare(m_Pos, size, literal) != 0)
+            return false;
+
+        m_Pos += size;
+        return true;
+    }
+
+    JsonValue ParseValue()
+    {
+        JsonValue value;
+
+        char c = Peek();
+        value.m_Line = m_Line;
+
+        if (c == '{')
+        {
+            value.m_Type = Type::Object;
+            m_Pos++;
+
+            if (Peek() == '}')
+            {
+                m_Pos++;
+                return value;
+            }
+
+            do
+            {
+                if (Peek() != '"')
+                    Fail("expected the name of a member");
+
+                value.m_Keys.push_back(ParseString());
+                Expect(':');
+                value.m_Items.push_back(ParseValue());
+            } while (Peek() == ',' && ++m_Pos);
+
+            Expect('}');
+        }
+        else if (c == '[')
+        {
+            value.m_Type = Type::Array;
+            m_Pos++;
+
+            if (Peek() == ']')
+            {
+                m_Pos++;
+                return value;
+            }
+
+            do
+            {
+                value.m_Items.push_back(ParseValue());
+            } while (Peek() == ',' && ++m_Pos);
+
+            Expect(']');
+        }
+        else if (c == '"')
+        {
+            value.m_Type = Type::String;
+            value.m_String = ParseString();
+        }
+        else if (Consume("true"))
+        {
+            value.m_Type = Type::Bool;
+            value.m_Bool = true;
+        }
+        else if (Consume("false"))
+        {
+            value.m_Type = Type::Bool;
+            value.m_Bool = false;
+        }
+        else if (Consume("null"))
+        {
+            value.m_Type = Type::Null;
+        }
+        else if (c == '-' || (c >= '0' && c <= '9'))
+        {
+            const char *start = m_Text.c_str() + m_Pos;
+            char *end;
+
+            value.m_Type = Type::Number;
+            value.m_Number = strtod(start, &end);
+
+            if (end == start)
+                Fail("invalid number");
+
+            m_Pos += end - start;
+        }
+        else
+        {
+            Fail(std::string("unexpected character '") + c + "'");
+        }
+
+        return value;
+    }
+
+    std::string ParseString()
+    {
+        std::string value;
+
+        // Skip the opening quote
+        m_Pos++;
+
+        while (true)
+        {
+            if (m_Pos >= m_Text.size())
+                Fail("unterminated string");
+
+            char c = m_Text[m_Pos++];
+
+            if (c == '"')
+                return value;
+
+            if (c == '\n')
+                Fail("new line inside of a string");
+
+            if (c != '\\')
+            {
+                value += c;
+                continue;
+            }
+
+            if (m_Pos >= m_Text.size())
+                Fail("unterminated string");
+
+            switch (m_Text[m_Pos++])
+            {
+            case '"':
+                value += '"';
+                break;
+            case '\\':
+                value += '\\';
+                break;
+            case '/':
+                value += '/';
+                break;
+            case 'b':
+                value += '\b';
+                break;
+            case 'f':
+                value += '\f';
+                break;
+            case 'n':
+                value += '\n';
+                break;
+            case 'r':
+                value += '\r';
+                break;
+            case 't':
+                value += '\t';
+                break;
+            case 'u':
+                AppendCodePoint(value);
+                break;
+            default:
+                Fail("invalid escape sequence");
+            }
+        }
+    }
+
+    /// Decode a \uXXXX escape (the "\u" is already consumed) as UTF-8
+    void AppendCodePoint(std::string &value)
+    {
+        if (m_Pos + 4 > m_Text.size())
+            Fail("invalid unicode escape");
+
+        char *end;
+        std::string digits = m_Text.substr(m_Pos, 4);
+        uint32_t code = strtoul(digits.c_str(), &end, 16);
+
+        if (end != digits.c_str() + 4)
+            Fail("invalid unicode escape");
+
+        m_Pos += 4;
+
+        // Surrogate pairs are not combined, configuration files don't need them
+        if (code < 0x80)
+        {
+            value += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            value += static_cast<char>(0xC0 | (code >> 6));
+            value += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            value += static_cast<char>(0xE0 | (code >> 12));
+            value += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            value += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    const std::string &m_Text;
+    const std::string &m_Source;
+    size_t m_Pos = 0;
+    uint32_t m_Line = 1;
+};
+
+JsonValue
+JsonValue::Parse(const std::string &text, const std::string &source)
+{
+    return Parser(text, source).ParseDocument();
+}
+
+JsonValue
+JsonValue::ParseFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file)
+        NS_FATAL_ERROR("Failed to open '" << path << "'");
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+
+    return Parse(buffer.str(), path);
+}
+
+JsonValue::Type
+JsonValue::GetType() const
+{
+    return m_Type;
+}
+
+bool
+JsonValue::IsNull() const
+{
+    return m_Type == Type::Null;
+}
+
+bool
+JsonValue::AsBool() const
+{
+    if (m_Type != Type::Bool)
+        TypeError(Type::Bool);
+
+    return m_Bool;
+}
+
+double
+JsonValue::AsNumber() const
+{
+    if (m_Type != Type::Number)
+        TypeError(Type::Number);
+
+    return m_Number;
+}
+
+const std::string &
+JsonValue::AsString() const
+{
+    if (m_Type != Type::String)
+        TypeError(Type::String);
+
+    return m_String;
+}
+
+const std::vector<JsonValue> &
+JsonValue::AsArray() const
+{
+    if (m_Type != Type::Array)
+        TypeError(Type::Array);
+
+    return m_Items;
+}
+
+bool
+JsonValue::Has(const std::string &key) const
+{
+    return Find(key) != nullptr;
+}
+
+const JsonValue &
+JsonValue::operator[](const std::string &key) const
+{
+    const JsonValue *value = Find(key);
+
+    if (!value)
+        NS_FATAL_ERROR("Line " << m_Line << ": missing member '" << key << "'");
+
+    return *value;
+}
+
+bool
+JsonValue::GetBool(const std::string &key, bool fallback) const
+{
+    const JsonValue *value = Find(key);
+    return value ? value->AsBool() : fallback;
+}
+
+double
+JsonValue::GetNumber(const std::string &key, double fallback) const
+{
+    const JsonValue *value = Find(key);
+    return value ? value->AsNumber() : fallback;
+}
+
+std::string
+JsonValue::GetString(const std::string &key, const std::string &fallback) const
+{
+    const JsonValue *value = Find(key);
+    return value ? value->AsString() : fallback;
+}
+
+const std::vector<std::string> &
+JsonValue::GetKeys() const
+{
+    if (m_Type != Type::Object)
+        TypeError(Type::Object);
+
+    return m_Keys;
+}
+
+uint32_t
+JsonValue::GetLine() const
+{
+    return m_Line;
+}
+
+void
+JsonValue::TypeError(Type expected) const
+{
+    NS_FATAL_ERROR("Line " << m_Line << ": expected " << GetTypeName(expected) << " but got "
+                           << GetTypeName(m_Type));
+}
+
+const JsonValue *
+JsonValue::Find(const std::string &key) const
+{
+    if (m_Type != Type::Object)
+        TypeError(Type::Object);
+
+    for (size_t i = 0; i < m_Keys.size(); i++)
+    {
+        if (m_Keys[i] == key)
+            return &m_Items[i];
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A parsed JSON document (or any value inside of it).
+ *
+ * Only meant for reading configuration files, so values are immutable once
+ * parsed. Syntax errors and accessing a value as the wrong type are fatal
+ * errors that report where the problem is.
+ */
+class JsonValue
+{
+public:
+    enum class Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    JsonValue() = default;
+
+    /**
+     * Parse a JSON document, `source` is used to report errors (e.g. the file name)
+     */
+    static JsonValue Parse(const std::string &text, const std::string &source = "json");
+
+    /// Read and parse a JSON file
+    static JsonValue ParseFile(const std::string &path);
+
+    Type GetType() const;
+
+    bool IsNull() const;
+
+    bool AsBool() const;
+
+    double AsNumber() const;
+
+    const std::string &AsString() const;
+
+    /// Elements of an array
+    const std::vector<JsonValue> &AsArray() const;
+
+    /// Whether the object has the given member
+    bool Has(const std::string &key) const;
+
+    /// Member of an object, missing members are a fatal error
+    const JsonValue &operator[](const std::string &key) const;
+
+    /*
+     * Members of an object with a default for when they're missing
+     */
+    bool GetBool(const std::string &key, bool fallback) const;
+
+    double GetNumber(const std::string &key, double fallback) const;
+
+    std::string GetString(const std::string &key, const std::string &fallback) const;
+
+    /// Names of the members of an object, in the order of the document
+    const std::vector<std::string> &GetKeys() const;
+
+    /// Line of the document where the value starts, for errors
+    uint32_t GetLine() const;
+
+private:
+    class Parser;
+
+    /// Fail because the value is not of the expected type
+    [[noreturn]] void TypeError(Type expected) const;
+
+    /// Member of an object or null if it doesn't exist
+    const JsonValue *Find(const std::string &key) const;
+
+    Type m_Type = Type::Null;
+    bool m_Bool = false;
+    double m_Number = 0;
+    std::string m_String;
+    std::vector<JsonValue> m_Items;  //!< Elements of an array or values of an object
+    std::vector<std::string> m_Keys; //!< Names of the members of an object
+    uint32_t m_Line = 0;             //!< Position in the document, for errors
+};
@@ -0,0 +1,74 @@
+#include "modbus-batcher.h"
+#include "profiler.h"
+
+#include "ns3/simulator.h"
+
+ModbusBatcher::~ModbusBatcher()
+{
+    Clear();
+}
+
+void
+ModbusBatcher::SetEnabled(bool enable)
+{
+    if (!enable)
+        Flush();
+
+    m_Enabled = enable;
+}
+
+void
+ModbusBatcher::Queue(ns3::Ptr<ns3::Socket> socket, const ModbusADU &adu)
+{
+    m_AdusSent++;
+
+    if (!m_Enabled)
+    {
+        socket->Send(adu.ToPacket());
+        m_PacketsSent++;
+        return;
+    }
+
+    adu.AppendTo(m_Buffers[socket]);
+
+    // The first ADU of this instant schedules the flush for the end of it
+    if (m_FlushEvent.IsExpired())
+        m_FlushEvent = ns3::Simulator::ScheduleNow(&ModbusBatcher::Flush, this);
+}
+
+void
+ModbusBatcher::Flush()
+{
+    TINYICS_PROFILE_SCOPE("batcher_flush", "");
+
+    for (auto &[socket, buffer] : m_Buffers)
+    {
+        if (buffer.empty())
+            continue;
+
+        socket->Send(ns3::Create<ns3::Packet>(buffer.data(), buffer.size()));
+        m_PacketsSent++;
+    }
+
+    m_Buffers.clear();
+    m_FlushEvent.Cancel();
+}
+
+void
+ModbusBatcher::Clear()
+{
+    m_Buffers.clear();
+    m_FlushEvent.Cancel();
+}
+
+uint64_t
+ModbusBatcher::GetPacketsSent() const
+{
+    return m_PacketsSent;
+}
+
+uint64_t
+ModbusBatcher::GetAdusSent() const
+{
+    return m_AdusSent;
+}
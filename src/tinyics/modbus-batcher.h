@@ -0,0 +1,46 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "ns3/event-id.h"
+#include "ns3/socket.h"
+
+#include "modbus.h"
+
+/**
+ * Outbound gather-write buffer per socket.
+ *
+ * ADUs queued during the same simulation instant are serialized back to
+ * back into one buffer per socket, which is sent as a single packet once
+ * the events already scheduled for that instant ran. This saves the
+ * per-packet TCP/IP/CSMA overhead and simulator events of sending each
+ * ADU on its own.
+ */
+class ModbusBatcher
+{
+public:
+    ~ModbusBatcher();
+
+    /// Disabled by default: every ADU is sent right away, one packet per ADU
+    void SetEnabled(bool enable);
+
+    void Queue(ns3::Ptr<ns3::Socket> socket, const ModbusADU &adu);
+
+    /// Send the buffered ADUs, one packet per socket
+    void Flush();
+
+    /// Discard the buffered ADUs without sending them
+    void Clear();
+
+    uint64_t GetPacketsSent() const;
+
+    uint64_t GetAdusSent() const;
+
+private:
+    bool m_Enabled = false;
+    std::map<ns3::Ptr<ns3::Socket>, std::vector<uint8_t>> m_Buffers; //!< Pending bytes per socket
+    ns3::EventId m_FlushEvent;
+    uint64_t m_PacketsSent = 0;
+    uint64_t m_AdusSent = 0;
+};
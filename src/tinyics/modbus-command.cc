@@ -9,12 +9,16 @@ Command::GetStart() const
     return m_Ref;
 }
 
-void
-Command::Execute(ns3::Ptr<ns3::Socket> socket, uint16_t tid, uint8_t uid) const
+MB_FunctionCode
+Command::GetFunctionCode() const
 {
-    std::vector<uint16_t> data(2);
+    return m_FunctionCode;
+}
 
-    // if (m_pending) return;
+ModbusADU
+Command::Build(uint16_t tid, uint8_t uid) const
+{
+    std::vector<uint16_t> data(2);
 
     data[0] = m_Ref;
     data[1] = m_Value;
@@ -25,7 +29,14 @@ Command::Execute(ns3::Ptr<ns3::Socket> socket, uint16_t tid, uint8_t uid) const
     adu.SetFunctionCode(m_FunctionCode);
 
     adu.SetData<uint16_t>(data);
-    ns3::Ptr<ns3::Packet> p = adu.ToPacket();
+
+    return adu;
+}
+
+void
+Command::Execute(ns3::Ptr<ns3::Socket> socket, uint16_t tid, uint8_t uid) const
+{
+    ns3::Ptr<ns3::Packet> p = Build(tid, uid).ToPacket();
     socket->Send(p);
 }
 
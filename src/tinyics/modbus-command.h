@@ -12,6 +12,11 @@ public:
 
     uint16_t GetStart() const;
 
+    MB_FunctionCode GetFunctionCode() const;
+
+    /// Build the request ADU for this command
+    ModbusADU Build(uint16_t tid, uint8_t uid) const;
+
     void Execute(ns3::Ptr<ns3::Socket> socket, uint16_t tid, uint8_t uid) const;
 
 protected:
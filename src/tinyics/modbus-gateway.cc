@@ -0,0 +1,283 @@
+#include "modbus-gateway.h"
+#include "profiler.h"
+
+#include "ns3/simulator.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Maximum amount of events handled on each call to epoll_wait
+#define GW_MAX_EVENTS 64
+
+// Size of the buffer used to read from the host sockets
+#define GW_READ_SZ 4096
+
+ModbusGateway::ModbusGateway()
+{
+    m_Epoll = epoll_create1(EPOLL_CLOEXEC);
+
+    if (m_Epoll == -1)
+        NS_FATAL_ERROR("Failed to create epoll instance for the Modbus gateway");
+}
+
+ModbusGateway::~ModbusGateway()
+{
+    Stop();
+    close(m_Epoll);
+}
+
+void
+ModbusGateway::AddPLC(uint16_t port, uint8_t uid, ns3::Ptr<PlcApplication> plc)
+{
+    auto &units = m_Units[port];
+
+    if (units.find(uid) != units.end())
+        NS_FATAL_ERROR("Unit id " << (int)uid << " already in use on gateway port " << port);
+
+    units[uid] = plc;
+
+    // Only the first PLC on a port opens the listener
+    if (units.size() == 1)
+        Listen(port);
+}
+
+void
+ModbusGateway::Listen(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        NS_FATAL_ERROR("Failed to create host socket for gateway port " << port);
+
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1 || listen(fd, 64) == -1)
+        NS_FATAL_ERROR("Failed to listen on 127.0.0.1:" << port << " for the Modbus gateway");
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event);
+
+    m_Listeners[fd] = port;
+}
+
+void
+ModbusGateway::Start(uint64_t interval)
+{
+    m_Interval = interval;
+
+    m_PollEvent.Cancel();
+    m_PollEvent = ns3::Simulator::ScheduleNow(&ModbusGateway::Poll, this);
+}
+
+void
+ModbusGateway::Stop()
+{
+    m_PollEvent.Cancel();
+
+    while (!m_Clients.empty())
+        Close(m_Clients.begin()->first);
+
+    for (auto &[fd, port] : m_Listeners)
+        close(fd);
+
+    m_Listeners.clear();
+    m_Units.clear();
+}
+
+uint16_t
+ModbusGateway::GetClientCount() const
+{
+    return m_Clients.size();
+}
+
+uint64_t
+ModbusGateway::GetRequestCount() const
+{
+    return m_Requests;
+}
+
+void
+ModbusGateway::Poll()
+{
+    TINYICS_PROFILE_SCOPE("host_gateway", "");
+
+    epoll_event events[GW_MAX_EVENTS];
+    int ready;
+
+    do
+    {
+        ready = epoll_wait(m_Epoll, events, GW_MAX_EVENTS, 0);
+
+        for (int i = 0; i < ready; i++)
+        {
+            int fd = events[i].data.fd;
+
+            if (m_Listeners.find(fd) != m_Listeners.end())
+            {
+                Accept(fd);
+                continue;
+            }
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+            {
+                Close(fd);
+                continue;
+            }
+
+            if (events[i].events & EPOLLIN)
+                Read(fd);
+
+            if ((events[i].events & EPOLLOUT) && m_Clients.find(fd) != m_Clients.end())
+                Write(fd);
+        }
+    } while (ready == GW_MAX_EVENTS);
+
+    m_PollEvent =
+        ns3::Simulator::Schedule(ns3::MilliSeconds(m_Interval), &ModbusGateway::Poll, this);
+}
+
+void
+ModbusGateway::Accept(int listener)
+{
+    int fd;
+    while ((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        // Responses are small, don't wait to coalesce them
+        int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event);
+
+        m_Clients[fd].port = m_Listeners[listener];
+    }
+}
+
+void
+ModbusGateway::Read(int fd)
+{
+    auto it = m_Clients.find(fd);
+    if (it == m_Clients.end())
+        return;
+
+    Client &client = it->second;
+
+    uint8_t buffer[GW_READ_SZ];
+    ssize_t count;
+
+    while ((count = read(fd, buffer, sizeof(buffer))) > 0)
+        client.input.insert(client.input.end(), buffer, buffer + count);
+
+    // Failed with something other than "try again"
+    if (count == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        Close(fd);
+        return;
+    }
+
+    // Closed by the client, which may still read the answers to what it sent
+    if (count == 0)
+        client.closing = true;
+
+    uint32_t consumed;
+    std::vector<ModbusADU> requests =
+        ModbusADU::GetModbusADUs(client.input.data(), client.input.size(), consumed);
+
+    client.input.erase(client.input.begin(), client.input.begin() + consumed);
+
+    std::vector<ModbusADU> responses;
+    auto &units = m_Units[client.port];
+
+    for (const ModbusADU &request : requests)
+    {
+        // There's no PLC behind the unit id, answer like a real gateway would
+        auto unit = units.find(request.GetUnitID());
+        if (unit == units.end())
+        {
+            responses.push_back(
+                request.MakeException(MB_ExceptionCode::GatewayPathUnavailable));
+            continue;
+        }
+
+        unit->second->ProcessRequest(request, responses);
+        m_Requests++;
+    }
+
+    for (const ModbusADU &response : responses)
+        response.AppendTo(client.output);
+
+    if (!client.output.empty())
+        Write(fd);
+    else if (client.closing)
+        Close(fd);
+}
+
+void
+ModbusGateway::Write(int fd)
+{
+    Client &client = m_Clients[fd];
+
+    // A client that is gone must not raise SIGPIPE and kill the simulation
+    ssize_t count = send(fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+
+    if (count == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        Close(fd);
+        return;
+    }
+
+    if (count > 0)
+        client.output.erase(client.output.begin(), client.output.begin() + count);
+
+    if (client.closing && client.output.empty())
+    {
+        Close(fd);
+        return;
+    }
+
+    // Wait for the socket to be writable again if not everything was sent
+    if (client.closing || client.watchOutput != !client.output.empty())
+        WatchOutput(fd, !client.output.empty());
+}
+
+void
+ModbusGateway::WatchOutput(int fd, bool enable)
+{
+    Client &client = m_Clients[fd];
+    client.watchOutput = enable;
+
+    // Nothing left to read from a closing client, only the answers to write
+    epoll_event event{};
+
+    if (!client.closing)
+        event.events |= EPOLLIN | EPOLLRDHUP;
+
+    if (enable)
+        event.events |= EPOLLOUT;
+
+    event.data.fd = fd;
+    epoll_ctl(m_Epoll, EPOLL_CTL_MOD, fd, &event);
+}
+
+void
+ModbusGateway::Close(int fd)
+{
+    epoll_ctl(m_Epoll, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+
+    m_Clients.erase(fd);
+}
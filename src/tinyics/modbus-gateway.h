@@ -0,0 +1,80 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "ns3/event-id.h"
+
+#include "plc-application.h"
+
+/**
+ * Bridges simulated PLCs to real Modbus TCP clients on the host.
+ *
+ * The gateway listens on loopback ports of the host machine, each port maps
+ * unit ids to simulated PLCs. External software (HMIs, historians) connects
+ * to those ports and its requests are served by the PLC's RequestProcessor
+ * as if they had arrived through the simulated network.
+ *
+ * The host sockets are non-blocking and multiplexed with epoll, they are
+ * polled from a simulator event every poll interval, so everything runs in
+ * the simulator thread. To get low latency the simulation should be paced
+ * (see SimulationRunner). Only supported on Linux.
+ */
+class ModbusGateway
+{
+public:
+    ModbusGateway();
+    ~ModbusGateway();
+
+    /**
+     * Serve the PLC on the given local port for the given unit id.
+     *
+     * Several PLCs can share a port as long as they use different unit ids.
+     */
+    void AddPLC(uint16_t port, uint8_t uid, ns3::Ptr<PlcApplication> plc);
+
+    /// Start polling the host sockets every `interval` simulated milliseconds
+    void Start(uint64_t interval = 1);
+
+    /// Stop polling and close every host socket
+    void Stop();
+
+    uint16_t GetClientCount() const;
+
+    uint64_t GetRequestCount() const;
+
+private:
+    /// A connected external client
+    struct Client
+    {
+        uint16_t port;               //!< Local port the client connected to
+        std::vector<uint8_t> input;  //!< Bytes received that don't form a full ADU yet
+        std::vector<uint8_t> output; //!< Bytes that could not be written yet
+        bool watchOutput = false;    //!< Waiting for the socket to be writable
+        bool closing = false;        //!< Closed by the client, close once the answers are sent
+    };
+
+    void Listen(uint16_t port);
+
+    /// Handle every ready host socket without blocking, then reschedule
+    void Poll();
+
+    void Accept(int listener);
+
+    void Read(int fd);
+
+    void Write(int fd);
+
+    void Close(int fd);
+
+    /// Update the epoll events for the client, depending on pending output
+    void WatchOutput(int fd, bool enable);
+
+    int m_Epoll = -1;
+    uint64_t m_Interval = 1;
+    ns3::EventId m_PollEvent;
+    std::map<int, uint16_t> m_Listeners;                                  //!< fd -> port
+    std::map<int, Client> m_Clients;                                      //!< fd -> client
+    std::map<uint16_t, std::map<uint8_t, ns3::Ptr<PlcApplication>>> m_Units; //!< port -> uid -> PLC
+    uint64_t m_Requests = 0;
+};
@@ -1,106 +1,150 @@
 #include "modbus-request.h"
 
+#include "bit-packing.h"
+
+constexpr std::array<RequestProcessor::Handler, MB_FUNCTION_CODES>
+RequestProcessor::MakeHandlers()
+{
+    std::array<Handler, MB_FUNCTION_CODES> handlers{};
+
+    handlers[MB_FunctionCode::ReadCoils] = &RequestProcessor::DigitalReadRequest;
+    handlers[MB_FunctionCode::ReadDiscreteInputs] = &RequestProcessor::DigitalReadRequest;
+    handlers[MB_FunctionCode::ReadInputRegisters] = &RequestProcessor::ReadRegistersRequest;
+    handlers[MB_FunctionCode::WriteSingleCoil] = &RequestProcessor::WriteCoilRequest;
+    handlers[MB_FunctionCode::WriteMultipleCoils] = &RequestProcessor::WriteCoilsRequest;
+
+    return handlers;
+}
+
+const std::array<RequestProcessor::Handler, MB_FUNCTION_CODES> RequestProcessor::s_Handlers =
+    RequestProcessor::MakeHandlers();
+
 void
 RequestProcessor::Execute(MB_FunctionCode fc,
-                          Socket sock,
-                          const ns3::Address &from,
                           const ModbusADU &adu,
-                          PlcState &state)
+                          PlcState &state,
+                          std::vector<ModbusADU> &responses)
 {
-    switch (fc)
+    Handler handler = s_Handlers[fc & 0x7F];
+
+    if (!handler)
     {
-    case MB_FunctionCode::ReadCoils:
-    case MB_FunctionCode::ReadDiscreteInputs:
-        DigitalReadRequest(sock, from, adu, state);
-        break;
-
-    case MB_FunctionCode::ReadInputRegisters:
-        ReadRegistersRequest(sock, from, adu, state);
-        break;
-
-    case MB_FunctionCode::WriteSingleCoil:
-        WriteCoilRequest(sock, from, adu, state);
-        break;
+        responses.push_back(adu.MakeException(MB_ExceptionCode::IllegalFunction));
+        return;
     }
+
+    handler(adu, state, responses);
 }
 
 void
-RequestProcessor::DigitalReadRequest(Socket sock,
-                                     const ns3::Address &from,
-                                     const ModbusADU &adu,
-                                     PlcState &state)
+RequestProcessor::DigitalReadRequest(const ModbusADU &adu,
+                                     PlcState &state,
+                                     std::vector<ModbusADU> &responses)
 {
-    uint16_t start = CombineUint8(adu.GetDataByte(0), adu.GetDataByte(1));
-    uint16_t num = CombineUint8(adu.GetDataByte(2), adu.GetDataByte(3));
+    uint16_t start = adu.GetDataWordUnchecked(0);
+    uint16_t num = adu.GetDataWordUnchecked(2);
 
-    // 0 <= start <= 7 (max start address)
-    // 1 <= num <= 8 (max amount coils/inputs to read)
-    if (start < 7 && 0 < num && num <= 8 - start)
+    // The range must fit in the coils/inputs of the PLC
+    if (start >= PLC_DIGITAL_PORTS || num == 0 || num > PLC_DIGITAL_PORTS - start)
     {
-        std::vector<uint8_t> data(2);
-        data[0] = 1; // Set bit count
-        data[1] = state.GetBits(start, num);
+        responses.push_back(adu.MakeException(MB_ExceptionCode::IllegalDataAddress));
+        return;
+    }
 
-        ModbusADU response;
-        ModbusADU::CopyBase(adu, response);
-        response.SetData(data);
+    // Byte count followed by the bits packed LSB first
+    std::vector<uint8_t> data(1 + PackedSize(num));
+    data[0] = PackedSize(num);
+    state.ReadBits(start, num, data.data() + 1);
 
-        ns3::Ptr<ns3::Packet> p = response.ToPacket();
-        sock->SendTo(p, 0, from);
-    }
+    ModbusADU response;
+    ModbusADU::CopyBase(adu, response);
+    response.SetData(data);
+
+    responses.push_back(std::move(response));
 }
 
 void
-RequestProcessor::ReadRegistersRequest(Socket sock,
-                                       const ns3::Address &from,
-                                       const ModbusADU &adu,
-                                       PlcState &state)
+RequestProcessor::ReadRegistersRequest(const ModbusADU &adu,
+                                       PlcState &state,
+                                       std::vector<ModbusADU> &responses)
 {
-    uint16_t start = CombineUint8(adu.GetDataByte(0), adu.GetDataByte(1));
-    uint16_t num = CombineUint8(adu.GetDataByte(2), adu.GetDataByte(3));
+    uint16_t start = adu.GetDataWordUnchecked(0);
+    uint16_t num = adu.GetDataWordUnchecked(2);
 
-    // 0 <= startAddres <= 1 (max address)
-    // 1 <= numRegisters <= 2 (max amount of input registers to read)
-    if (start <= 1 && 0 < num && num <= 2)
+    // The range must fit in the input registers of the PLC
+    if (start >= PLC_ANALOG_PORTS || num == 0 || num > PLC_ANALOG_PORTS - start)
     {
-        // Last In Register To Read
-        uint16_t end = num + start - 1;
-
-        std::vector<uint8_t> data(1 + 2 * num); // Registers are 16 bits
-        data[0] = 2 * num;                      // Set byte count
+        responses.push_back(adu.MakeException(MB_ExceptionCode::IllegalDataAddress));
+        return;
+    }
 
-        uint8_t count = 1;
-        for (int i = start; i <= end; i++)
-        {
-            auto [higher, lower] = SplitUint16(state.GetAnalogState(i));
+    // Last In Register To Read
+    uint16_t end = num + start - 1;
 
-            data[count] = static_cast<uint8_t>(higher);
-            data[count + 1] = static_cast<uint8_t>(lower);
+    std::vector<uint8_t> data(1 + 2 * num); // Registers are 16 bits
+    data[0] = 2 * num;                      // Set byte count
 
-            count += 2;
-        }
+    uint16_t count = 1;
+    for (int i = start; i <= end; i++)
+    {
+        auto [higher, lower] = SplitUint16(state.GetAnalogState(i));
 
-        ModbusADU response;
-        ModbusADU::CopyBase(adu, response);
-        response.SetData(data);
+        data[count] = static_cast<uint8_t>(higher);
+        data[count + 1] = static_cast<uint8_t>(lower);
 
-        // TODO: Maybe this should return the ModbusADU
-        ns3::Ptr<ns3::Packet> p = response.ToPacket();
-        sock->SendTo(p, 0, from);
+        count += 2;
     }
+
+    ModbusADU response;
+    ModbusADU::CopyBase(adu, response);
+    response.SetData(data);
+
+    responses.push_back(std::move(response));
 }
 
 void
-RequestProcessor::WriteCoilRequest(Socket sock,
-                                   const ns3::Address &from,
-                                   const ModbusADU &adu,
-                                   PlcState &state)
+RequestProcessor::WriteCoilRequest(const ModbusADU &adu,
+                                   PlcState &state,
+                                   std::vector<ModbusADU> &responses)
 {
-    uint16_t pos = CombineUint8(adu.GetDataByte(0), adu.GetDataByte(1));
-    uint16_t value = CombineUint8(adu.GetDataByte(2), adu.GetDataByte(3));
+    uint16_t pos = adu.GetDataWordUnchecked(0);
+    uint16_t value = adu.GetDataWordUnchecked(2);
+
+    // The coil must exist in the PLC
+    if (pos >= PLC_DIGITAL_PORTS)
+    {
+        responses.push_back(adu.MakeException(MB_ExceptionCode::IllegalDataAddress));
+        return;
+    }
 
     state.SetDigitalState(pos, value > 0);
 
-    ns3::Ptr<ns3::Packet> p = adu.ToPacket();
-    sock->SendTo(p, 0, from);
+    // The response is an echo of the request
+    responses.push_back(adu);
+}
+
+void
+RequestProcessor::WriteCoilsRequest(const ModbusADU &adu,
+                                    PlcState &state,
+                                    std::vector<ModbusADU> &responses)
+{
+    uint16_t start = adu.GetDataWordUnchecked(0);
+    uint16_t num = adu.GetDataWordUnchecked(2);
+
+    // The range must fit in the coils of the PLC
+    if (start >= PLC_DIGITAL_PORTS || num > PLC_DIGITAL_PORTS - start)
+    {
+        responses.push_back(adu.MakeException(MB_ExceptionCode::IllegalDataAddress));
+        return;
+    }
+
+    // The values follow the start, amount and byte count
+    state.WriteBits(start, num, adu.GetDataUnchecked() + 5);
+
+    // The response echoes the start and the amount of coils written
+    ModbusADU response;
+    ModbusADU::CopyBase(adu, response);
+    response.SetData(std::vector<uint16_t>{start, num});
+
+    responses.push_back(std::move(response));
 }
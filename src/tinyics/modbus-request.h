@@ -1,12 +1,12 @@
 #pragma once
 
-#include "ns3/socket.h"
+#include <array>
+#include <vector>
 
+#include "modbus-traits.h"
 #include "modbus.h"
 #include "plc-state.h"
 
-using Socket = ns3::Ptr<ns3::Socket>;
-
 class RequestProcessor
 {
 public:
@@ -14,27 +14,38 @@ public:
 
     // TODO: The function code is already known from the modbus ADU
     /**
-     * Processes the incoming request and sends the response through the provided socket
+     * Processes the incoming request and appends the response to the provided list,
+     * so that all the responses to a segment can be sent together.
+     *
+     * The request must have passed ModbusADU::IsValidFrame and ValidateRequest,
+     * its data is read without bounds checks.
      */
     static void Execute(MB_FunctionCode fc,
-                        Socket sock,
-                        const ns3::Address &from,
                         const ModbusADU &adu,
-                        PlcState &state);
+                        PlcState &state,
+                        std::vector<ModbusADU> &responses);
 
 private:
-    static void DigitalReadRequest(Socket sock,
-                                   const ns3::Address &from,
-                                   const ModbusADU &adu,
-                                   PlcState &state);
-
-    static void ReadRegistersRequest(Socket sock,
-                                     const ns3::Address &from,
-                                     const ModbusADU &adu,
-                                     PlcState &state);
-
-    static void WriteCoilRequest(Socket sock,
-                                 const ns3::Address &from,
-                                 const ModbusADU &adu,
-                                 PlcState &state);
+    using Handler = void (*)(const ModbusADU &, PlcState &, std::vector<ModbusADU> &);
+
+    /// Handler per function code, null for the unsupported ones
+    static constexpr std::array<Handler, MB_FUNCTION_CODES> MakeHandlers();
+
+    static const std::array<Handler, MB_FUNCTION_CODES> s_Handlers;
+
+    static void DigitalReadRequest(const ModbusADU &adu,
+                                   PlcState &state,
+                                   std::vector<ModbusADU> &responses);
+
+    static void ReadRegistersRequest(const ModbusADU &adu,
+                                     PlcState &state,
+                                     std::vector<ModbusADU> &responses);
+
+    static void WriteCoilRequest(const ModbusADU &adu,
+                                 PlcState &state,
+                                 std::vector<ModbusADU> &responses);
+
+    static void WriteCoilsRequest(const ModbusADU &adu,
+                                  PlcState &state,
+                                  std::vector<ModbusADU> &responses);
 };
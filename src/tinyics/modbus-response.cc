@@ -1,6 +1,22 @@
 #include "modbus-response.h"
 
-#include <cmath>
+#include "bit-packing.h"
+
+constexpr std::array<ModbusResponseProcessor::Handler, MB_FUNCTION_CODES>
+ModbusResponseProcessor::MakeHandlers()
+{
+    std::array<Handler, MB_FUNCTION_CODES> handlers{};
+
+    handlers[MB_FunctionCode::ReadCoils] = &ModbusResponseProcessor::DigitalReadResponse;
+    handlers[MB_FunctionCode::ReadDiscreteInputs] = &ModbusResponseProcessor::DigitalReadResponse;
+    handlers[MB_FunctionCode::ReadInputRegisters] = &ModbusResponseProcessor::RegisterReadResponse;
+    handlers[MB_FunctionCode::WriteSingleCoil] = &ModbusResponseProcessor::WriteCoilResponse;
+
+    return handlers;
+}
+
+const std::array<ModbusResponseProcessor::Handler, MB_FUNCTION_CODES>
+    ModbusResponseProcessor::s_Handlers = ModbusResponseProcessor::MakeHandlers();
 
 void
 ModbusResponseProcessor::Execute(MB_FunctionCode fc,
@@ -8,21 +24,24 @@ ModbusResponseProcessor::Execute(MB_FunctionCode fc,
                                  const std::vector<Var *> &vars,
                                  uint16_t start)
 {
-    switch (fc)
-    {
-    case MB_FunctionCode::ReadCoils:
-    case MB_FunctionCode::ReadDiscreteInputs:
-        DigitalReadResponse(adu, vars, start);
-        break;
-
-    case MB_FunctionCode::ReadInputRegisters:
-        RegisterReadResponse(adu, vars, start);
-        break;
-
-    case MB_FunctionCode::WriteSingleCoil:
-        WriteCoilResponse(adu, vars, start);
-        break;
-    }
+    Handler handler = s_Handlers[fc & 0x7F];
+
+    // Responses to function codes we don't know are ignored
+    if (handler)
+        handler(adu, vars, start);
+}
+
+MB_ExceptionCode
+ModbusResponseProcessor::GetException(const ModbusADU &adu)
+{
+    if (!(adu.GetFunctionCode() & 0x80))
+        return MB_ExceptionCode::NoException;
+
+    // Exception responses carry a single data byte, treat anything else as a failure
+    if (adu.GetLengthField() != 3)
+        return MB_ExceptionCode::ServerDeviceFailure;
+
+    return static_cast<MB_ExceptionCode>(adu.GetDataByteUnchecked(0));
 }
 
 void
@@ -38,21 +57,21 @@ ModbusResponseProcessor::DigitalReadResponse(const ModbusADU &adu,
 
     // Last position requested on ADU
 
-    uint8_t byte_count = adu.GetDataByte(0);
+    uint8_t byte_count = adu.GetDataByteUnchecked(0);
+
+    // The byte count must match the data that was actually received
+    if (byte_count != buff_size - 1)
+        return;
 
     for (auto var : vars)
     {
-        uint8_t pos = var->GetPosition() - start;
+        uint16_t pos = var->GetPosition() - start;
 
-        // The byte where the coil is and the position of the coil within that byte
-        uint8_t byte = std::trunc(pos / 8.0) + 1;
-        uint8_t bit = pos % 8;
+        if (pos >= 8 * byte_count)
+            continue;
 
-        // If the bit is turned on, then set the value to 1 (true) otherwise set the value
-        // to 0
-        uint8_t value = (GetBitsInRangeBE(bit, 1, adu.GetDataByte(byte)) > 0) ? 1 : 0;
-
-        var->SetValue(value);
+        // The bits are packed LSB first after the byte count
+        var->SetValue(GetPackedBit(adu.GetDataUnchecked() + 1, pos));
     }
 }
 
@@ -67,21 +86,22 @@ ModbusResponseProcessor::RegisterReadResponse(const ModbusADU &adu,
     if (buff_size == 0)
         return;
 
-    uint8_t byte_count = adu.GetDataByte(0);
+    uint8_t byte_count = adu.GetDataByteUnchecked(0);
+
+    // The byte count must match the data that was actually received
+    if (byte_count != buff_size - 1)
+        return;
 
     for (auto var : vars)
     {
         // Indicates the place of the height byte for the variable
-        uint8_t pos = var->GetPosition() - start;
+        uint16_t pos = var->GetPosition() - start;
 
-        if (pos > byte_count / 2)
-            return;
+        if (pos >= byte_count / 2)
+            continue;
 
         // We should add 1 here, to taking into consideration the byte_count
-        uint8_t high = adu.GetDataByte(2 * pos + 1);
-        uint8_t low = adu.GetDataByte(2 * pos + 2);
-
-        uint16_t value = CombineUint8(high, low);
+        uint16_t value = adu.GetDataWordUnchecked(2 * pos + 1);
 
         var->SetValue(value);
     }
@@ -100,7 +120,7 @@ ModbusResponseProcessor::WriteCoilResponse(const ModbusADU &adu,
         return;
 
     // Address/Position of the modified value in the RTU
-    uint16_t pos = CombineUint8(adu.GetDataByte(1), adu.GetDataByte(0));
+    uint16_t pos = CombineUint8(adu.GetDataByteUnchecked(1), adu.GetDataByteUnchecked(0));
 
     auto var = std::find_if(vars.begin(), vars.end(), [pos](const Var *v) {
         return v->GetPosition() == pos;
@@ -108,7 +128,8 @@ ModbusResponseProcessor::WriteCoilResponse(const ModbusADU &adu,
 
     if (var != vars.end())
     {
-        uint16_t value = CombineUint8(adu.GetDataByte(3), adu.GetDataByte(2));
+        uint16_t value =
+            CombineUint8(adu.GetDataByteUnchecked(3), adu.GetDataByteUnchecked(2));
         (*var)->SetValue(value);
     }
 }
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <array>
 #include <map>
 
+#include "modbus-traits.h"
 #include "modbus.h"
 #include "utils.h"
 #include "variables.h"
@@ -13,13 +15,30 @@ public:
 
     /**
      * Processes the incoming response and sends the response using the provided socket.
+     *
+     * The response must be a valid frame (see ModbusADU::IsValidFrame), its
+     * byte count is checked once against the length of the ADU.
      */
     static void Execute(MB_FunctionCode fc,
                         const ModbusADU &adu,
                         const std::vector<Var *> &vars,
                         uint16_t start);
 
+    /**
+     * Decode an exception response
+     *
+     * returns the exception code, or NoException if the ADU is a regular response
+     */
+    static MB_ExceptionCode GetException(const ModbusADU &adu);
+
 private:
+    using Handler = void (*)(const ModbusADU &, const std::vector<Var *> &, uint16_t);
+
+    /// Decoder per function code, null for the unsupported ones
+    static constexpr std::array<Handler, MB_FUNCTION_CODES> MakeHandlers();
+
+    static const std::array<Handler, MB_FUNCTION_CODES> s_Handlers;
+
     static void DigitalReadResponse(const ModbusADU &adu,
                                     const std::vector<Var *> &vars,
                                     uint16_t start);
@@ -0,0 +1,212 @@
+#include "modbus-rtu-gateway.h"
+
+#include "ns3/inet-socket-address.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+
+#include "modbus-rtu.h"
+#include "profiler.h"
+
+ns3::TypeId
+ModbusRtuGateway::GetTypeId()
+{
+    static ns3::TypeId tid = ns3::TypeId("ModbusRtuGateway")
+        .SetParent<Application>()
+        .SetGroupName("Applications");
+
+    return tid;
+}
+
+ModbusRtuGateway::ModbusRtuGateway(const char *name, std::shared_ptr<SerialBus> bus)
+    : IndustrialApplication(name),
+      m_Bus(bus)
+{
+    m_Bus->SetMasterCallback(MakeCallback(&ModbusRtuGateway::HandleResponse, this));
+}
+
+ModbusRtuGateway::~ModbusRtuGateway()
+{
+    m_Socket = nullptr;
+}
+
+void
+ModbusRtuGateway::DoDispose()
+{
+    Application::DoDispose();
+}
+
+void
+ModbusRtuGateway::SetResponseTimeout(uint64_t timeout)
+{
+    m_Timeout = ns3::MilliSeconds(timeout);
+}
+
+std::shared_ptr<SerialBus>
+ModbusRtuGateway::GetBus() const
+{
+    return m_Bus;
+}
+
+uint64_t
+ModbusRtuGateway::GetRequestCount() const
+{
+    return m_Requests;
+}
+
+uint64_t
+ModbusRtuGateway::GetTimeoutCount() const
+{
+    return m_Timeouts;
+}
+
+uint32_t
+ModbusRtuGateway::GetQueueLength() const
+{
+    return m_Queue.size() - (m_Busy ? 1 : 0);
+}
+
+void
+ModbusRtuGateway::StartApplication()
+{
+    if (!m_Socket)
+    {
+        ns3::TypeId tid = ns3::TypeId::LookupByName("ns3::TcpSocketFactory");
+        m_Socket = ns3::Socket::CreateSocket(GetNode(), tid);
+
+        ns3::InetSocketAddress local = ns3::InetSocketAddress(ns3::Ipv4Address::GetAny(), s_Port);
+        if (m_Socket->Bind(local) == -1)
+        {
+            NS_FATAL_ERROR("Failed to bind socket");
+        }
+    }
+
+    m_Socket->Listen();
+    m_Socket->SetAcceptCallback(
+        ns3::MakeNullCallback<bool, ns3::Ptr<ns3::Socket>, const ns3::Address &>(),
+        MakeCallback(&ModbusRtuGateway::HandleAccept, this));
+}
+
+void
+ModbusRtuGateway::StopApplication()
+{
+    m_Timer.Cancel();
+    m_Queue.clear();
+    m_Inputs.clear();
+    m_Busy = false;
+
+    if (m_Socket)
+    {
+        m_Socket->Close();
+        m_Socket->SetRecvCallback(ns3::MakeNullCallback<void, ns3::Ptr<ns3::Socket>>());
+    }
+}
+
+void
+ModbusRtuGateway::HandleAccept(ns3::Ptr<ns3::Socket> s, const ns3::Address &from)
+{
+    s->SetRecvCallback(MakeCallback(&ModbusRtuGateway::HandleRead, this));
+    s->SetCloseCallbacks(MakeCallback(&ModbusRtuGateway::HandleClose, this),
+                         MakeCallback(&ModbusRtuGateway::HandleClose, this));
+}
+
+void
+ModbusRtuGateway::HandleClose(ns3::Ptr<ns3::Socket> socket)
+{
+    m_Inputs.erase(socket);
+
+    // Requests of the client are still forwarded, but nobody gets the answer
+    for (Pending &pending : m_Queue)
+    {
+        if (pending.socket == socket)
+            pending.socket = nullptr;
+    }
+}
+
+void
+ModbusRtuGateway::HandleRead(ns3::Ptr<ns3::Socket> socket)
+{
+    TINYICS_PROFILE_SCOPE("gateway_read", GetName());
+
+    ModbusStream &input = m_Inputs[socket];
+
+    ns3::Ptr<ns3::Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        for (ModbusADU &adu : input.Read(packet))
+            m_Queue.push_back(Pending{socket, std::move(adu)});
+    }
+
+    Next();
+}
+
+void
+ModbusRtuGateway::Next()
+{
+    if (m_Busy || m_Queue.empty())
+        return;
+
+    m_Busy = true;
+    m_Requests++;
+
+    const ModbusADU &request = m_Queue.front().request;
+    ns3::Time sent = m_Bus->Send(ModbusRTU::Encode(request));
+
+    // Broadcasts are never answered, the bus is free after the turnaround time
+    ns3::Time wait = request.GetUnitID() == 0 ? m_Bus->GetTurnaround() : m_Timeout;
+
+    m_Timer = ns3::Simulator::Schedule(sent + wait - ns3::Simulator::Now(),
+                                       &ModbusRtuGateway::HandleTimeout,
+                                       this);
+}
+
+void
+ModbusRtuGateway::HandleResponse(std::vector<uint8_t> frame)
+{
+    // Late answer to a request that already timed out
+    if (!m_Busy)
+        return;
+
+    Pending &pending = m_Queue.front();
+
+    ModbusADU response;
+    if (!ModbusRTU::Decode(frame, pending.request.GetTransactionID(), response) ||
+        response.GetUnitID() != pending.request.GetUnitID())
+    {
+        return;
+    }
+
+    m_Timer.Cancel();
+
+    if (pending.socket)
+        pending.socket->Send(response.ToPacket());
+
+    m_Queue.pop_front();
+    m_Busy = false;
+
+    Next();
+}
+
+void
+ModbusRtuGateway::HandleTimeout()
+{
+    Pending &pending = m_Queue.front();
+
+    // Let the client know right away instead of waiting for its own timeout
+    if (pending.request.GetUnitID() != 0)
+    {
+        m_Timeouts++;
+
+        if (pending.socket)
+        {
+            pending.socket->Send(
+                pending.request.MakeException(MB_ExceptionCode::GatewayTargetFailedToRespond)
+                    .ToPacket());
+        }
+    }
+
+    m_Queue.pop_front();
+    m_Busy = false;
+
+    Next();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+
+#include "ns3/event-id.h"
+
+#include "industrial-application.h"
+#include "modbus.h"
+#include "serial-bus.h"
+
+namespace ns3
+{
+class Socket;
+} // namespace ns3
+
+/**
+ * Modbus TCP to Modbus RTU gateway.
+ *
+ * Listens for Modbus TCP clients (e.g. a SCADA) on the IP network and
+ * forwards their requests to the slaves of a serial bus, the unit id of the
+ * request is used as the slave address. The gateway is the single master of
+ * the bus, so requests are forwarded one at a time in the order they arrive
+ * and the rest wait in a queue. A SCADA reaches each slave by adding an RTU
+ * with the gateway's address and the slave's unit id.
+ */
+class ModbusRtuGateway : public IndustrialApplication
+{
+public:
+    /**
+     * Get the type ID.
+     *
+     * returns the object TypeId
+     */
+    static ns3::TypeId GetTypeId();
+
+    ModbusRtuGateway(const char *name, std::shared_ptr<SerialBus> bus);
+
+    ~ModbusRtuGateway() override;
+
+    /**
+     * Time in milliseconds to wait for a slave to answer, after that the
+     * client gets a "gateway target failed to respond" exception
+     */
+    void SetResponseTimeout(uint64_t timeout);
+
+    std::shared_ptr<SerialBus> GetBus() const;
+
+    /// Requests forwarded to the bus
+    uint64_t GetRequestCount() const;
+
+    /// Requests a slave never answered
+    uint64_t GetTimeoutCount() const;
+
+    /// Requests waiting for the bus
+    uint32_t GetQueueLength() const;
+
+protected:
+    void DoDispose() override;
+
+private:
+    void StartApplication() override;
+    void StopApplication() override;
+
+    void HandleAccept(ns3::Ptr<ns3::Socket> s, const ns3::Address &from);
+
+    void HandleRead(ns3::Ptr<ns3::Socket> socket);
+
+    void HandleClose(ns3::Ptr<ns3::Socket> socket);
+
+    /// Forward the next queued request if the bus is free
+    void Next();
+
+    /// A slave answered the request in progress
+    void HandleResponse(std::vector<uint8_t> frame);
+
+    /// The request in progress was not answered in time (or was a broadcast)
+    void HandleTimeout();
+
+    /// A request from a TCP client waiting for the bus
+    struct Pending
+    {
+        ns3::Ptr<ns3::Socket> socket; //!< Client to answer, null once it disconnects
+        ModbusADU request;
+    };
+
+    static constexpr uint16_t s_Port = 502; //!< Port on which we listen for clients
+    ns3::Ptr<ns3::Socket> m_Socket;
+    std::shared_ptr<SerialBus> m_Bus;
+    std::map<ns3::Ptr<ns3::Socket>, ModbusStream> m_Inputs; //!< Requests split across packets
+    std::deque<Pending> m_Queue; //!< Front is the request in progress when busy
+    bool m_Busy = false;         //!< Waiting for a slave to answer
+    ns3::EventId m_Timer;
+    ns3::Time m_Timeout = ns3::MilliSeconds(200);
+    uint64_t m_Requests = 0;
+    uint64_t m_Timeouts = 0;
+};
@@ -0,0 +1,90 @@
+#include "modbus-rtu.h"
+
+#include <array>
+
+namespace
+{
+
+constexpr std::array<uint16_t, 256>
+MakeCRCTable()
+{
+    std::array<uint16_t, 256> table{};
+
+    for (uint16_t i = 0; i < 256; i++)
+    {
+        uint16_t crc = i;
+
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+
+        table[i] = crc;
+    }
+
+    return table;
+}
+
+constexpr std::array<uint16_t, 256> s_CRCTable = MakeCRCTable();
+
+} // namespace
+
+uint16_t
+ModbusCRC16(const uint8_t *data, uint32_t size)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (uint32_t i = 0; i < size; i++)
+        crc = (crc >> 8) ^ s_CRCTable[(crc ^ data[i]) & 0xFF];
+
+    return crc;
+}
+
+std::vector<uint8_t>
+ModbusRTU::Encode(const ModbusADU &adu)
+{
+    std::vector<uint8_t> tcp;
+    adu.AppendTo(tcp);
+
+    // Drop the MBAP header up to the unit id, which becomes the slave address
+    std::vector<uint8_t> frame(tcp.begin() + UNIT_ID_POS, tcp.end());
+
+    uint16_t crc = ModbusCRC16(frame.data(), frame.size());
+    frame.push_back(crc & 0xFF);
+    frame.push_back(crc >> 8);
+
+    return frame;
+}
+
+bool
+ModbusRTU::Decode(const std::vector<uint8_t> &frame, uint16_t tid, ModbusADU &adu)
+{
+    if (frame.size() < RTU_BASE_SZ || frame.size() > RTU_MAX_SZ)
+        return false;
+
+    uint32_t size = frame.size() - 2;
+    uint16_t crc = frame[size] | (frame[size + 1] << 8);
+
+    if (ModbusCRC16(frame.data(), size) != crc)
+        return false;
+
+    // Rebuild the MBAP header in front of the address and PDU
+    uint16_t length = size;
+
+    std::vector<uint8_t> tcp = {
+        static_cast<uint8_t>(tid >> 8),
+        static_cast<uint8_t>(tid & 0xFF),
+        0,
+        0,
+        static_cast<uint8_t>(length >> 8),
+        static_cast<uint8_t>(length & 0xFF),
+    };
+    tcp.insert(tcp.end(), frame.begin(), frame.begin() + size);
+
+    uint32_t consumed;
+    std::vector<ModbusADU> adus = ModbusADU::GetModbusADUs(tcp.data(), tcp.size(), consumed);
+
+    if (adus.size() != 1)
+        return false;
+
+    adu = std::move(adus[0]);
+    return true;
+}
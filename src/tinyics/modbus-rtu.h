@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "modbus.h"
+
+// Size of an RTU frame without data field (address, function code and CRC)
+#define RTU_BASE_SZ 4
+
+// Size of the largest RTU frame allowed by the serial line specification
+#define RTU_MAX_SZ 256
+
+/**
+ * Modbus CRC-16 (polynomial 0xA001, initial value 0xFFFF).
+ *
+ * Computed a byte at a time with a 256 entry table built at compile time.
+ */
+uint16_t ModbusCRC16(const uint8_t *data, uint32_t size);
+
+/**
+ * Codec between Modbus TCP ADUs and Modbus RTU frames.
+ *
+ * An RTU frame carries the same PDU as the TCP ADU, but the MBAP header is
+ * replaced by the slave address (the unit id) and a CRC-16 is appended to
+ * the end, low byte first:
+ *
+ *   | address | function code | data | CRC lo | CRC hi |
+ */
+class ModbusRTU
+{
+public:
+    /// Serialize the ADU as an RTU frame
+    static std::vector<uint8_t> Encode(const ModbusADU &adu);
+
+    /**
+     * Parse an RTU frame into an ADU with the given transaction identifier.
+     *
+     * returns false if the frame is too short, too long or its CRC doesn't
+     * match, corrupted frames are discarded by the receiver.
+     */
+    static bool Decode(const std::vector<uint8_t> &frame, uint16_t tid, ModbusADU &adu);
+};
@@ -0,0 +1,164 @@
+#include "modbus-server.h"
+#include "profiler.h"
+
+#include "ns3/inet-socket-address.h"
+#include "ns3/packet.h"
+
+ModbusServer::ModbusServer(const char *component, const std::string &name, Handler handler)
+    : m_Component(component),
+      m_Name(name),
+      m_Handler(handler)
+{
+}
+
+void
+ModbusServer::Start(ns3::Ptr<ns3::Node> node, uint16_t port)
+{
+    if (!m_Socket)
+    {
+        // Create TCP socket
+        ns3::TypeId tid = ns3::TypeId::LookupByName("ns3::TcpSocketFactory");
+        m_Socket = ns3::Socket::CreateSocket(node, tid);
+
+        // Bind the socket to the local address
+        ns3::InetSocketAddress local = ns3::InetSocketAddress(ns3::Ipv4Address::GetAny(), port);
+        if (m_Socket->Bind(local) == -1)
+        {
+            NS_FATAL_ERROR("Failed to bind socket");
+        }
+    }
+
+    m_Socket->Listen();
+    m_Socket->SetAcceptCallback(MakeCallback(&ModbusServer::HandleConnectionRequest, this),
+                                MakeCallback(&ModbusServer::HandleAccept, this));
+}
+
+void
+ModbusServer::Stop()
+{
+    for (auto &[socket, connection] : m_Connections)
+    {
+        socket->SetRecvCallback(ns3::MakeNullCallback<void, ns3::Ptr<ns3::Socket>>());
+        socket->Close();
+    }
+    m_Connections.clear();
+    m_Batcher.Clear();
+
+    if (m_Socket)
+    {
+        m_Socket->Close();
+        m_Socket->SetRecvCallback(ns3::MakeNullCallback<void, ns3::Ptr<ns3::Socket>>());
+    }
+}
+
+void
+ModbusServer::SetMaxConnections(uint16_t max)
+{
+    m_MaxConnections = max;
+}
+
+void
+ModbusServer::SetQueueDepth(uint16_t depth)
+{
+    m_QueueDepth = depth;
+}
+
+void
+ModbusServer::SetBatching(bool enable)
+{
+    m_Batcher.SetEnabled(enable);
+}
+
+uint16_t
+ModbusServer::GetConnectionCount() const
+{
+    return m_Connections.size();
+}
+
+uint64_t
+ModbusServer::GetBusyRequests() const
+{
+    return m_BusyRequests;
+}
+
+uint64_t
+ModbusServer::GetMalformedRequests() const
+{
+    return m_MalformedRequests;
+}
+
+const ModbusBatcher &
+ModbusServer::GetBatcher() const
+{
+    return m_Batcher;
+}
+
+bool
+ModbusServer::HandleConnectionRequest(ns3::Ptr<ns3::Socket> s, const ns3::Address &from)
+{
+    return m_Connections.size() < m_MaxConnections;
+}
+
+void
+ModbusServer::HandleAccept(ns3::Ptr<ns3::Socket> s, const ns3::Address &from)
+{
+    m_Connections[s].peer = from;
+
+    s->SetRecvCallback(MakeCallback(&ModbusServer::HandleRead, this));
+    s->SetCloseCallbacks(MakeCallback(&ModbusServer::HandleClose, this),
+                         MakeCallback(&ModbusServer::HandleClose, this));
+}
+
+void
+ModbusServer::HandleClose(ns3::Ptr<ns3::Socket> s)
+{
+    m_Connections.erase(s);
+}
+
+void
+ModbusServer::HandleRead(ns3::Ptr<ns3::Socket> socket)
+{
+    TINYICS_PROFILE_SCOPE(m_Component, m_Name);
+
+    auto it = m_Connections.find(socket);
+    if (it == m_Connections.end())
+        return;
+
+    Connection &connection = it->second;
+
+    std::vector<ModbusADU> responses;
+    uint64_t served = 0;
+
+    // Serve the requests pipelined by the client up to the queue depth, the
+    // rest are refused so the client retries them instead of timing out
+    ns3::Ptr<ns3::Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        for (const ModbusADU &adu : connection.input.Read(packet))
+        {
+            // Malformed frames can't be answered reliably, drop them
+            if (!adu.IsValidFrame())
+            {
+                m_MalformedRequests++;
+                continue;
+            }
+
+            if (served < m_QueueDepth)
+            {
+                m_Handler(adu, responses);
+                served++;
+            }
+            else
+            {
+                responses.push_back(adu.MakeException(MB_ExceptionCode::ServerDeviceBusy));
+                m_BusyRequests++;
+            }
+        }
+    }
+
+    connection.requests += served;
+
+    // All the responses of this instant go back to the client in a single send
+    for (const ModbusADU &response : responses)
+        m_Batcher.Queue(socket, response);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ns3/address.h"
+#include "ns3/callback.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+
+#include "modbus-batcher.h"
+#include "modbus.h"
+
+/**
+ * Server side of Modbus TCP, shared by the applications that answer requests.
+ *
+ * It listens on a port of the node, keeps track of the accepted clients
+ * (up to a maximum), reassembles the requests each client sends and hands
+ * them to the handler, which appends the responses. The responses of the
+ * same instant go back to each client in a single packet.
+ *
+ * A client can pipeline requests, up to the queue depth are served per
+ * read and the rest are answered with ServerDeviceBusy, so the client
+ * retries them instead of waiting for a timeout. Requests with a
+ * malformed MBAP header are dropped before reaching the handler.
+ */
+class ModbusServer
+{
+public:
+    /// Runs a valid request and appends its response(s)
+    using Handler = ns3::Callback<void, const ModbusADU &, std::vector<ModbusADU> &>;
+
+    /**
+     * \param component name of the reads in the profiler
+     * \param name name of the application that owns the server
+     * \param handler called for every request served
+     */
+    ModbusServer(const char *component, const std::string &name, Handler handler);
+
+    /// Start listening for clients on the port of the node
+    void Start(ns3::Ptr<ns3::Node> node, uint16_t port);
+
+    /// Close the connection of every client and stop listening
+    void Stop();
+
+    /// Maximum amount of clients connected at the same time
+    void SetMaxConnections(uint16_t max);
+
+    /// Maximum amount of requests served per connection at once
+    void SetQueueDepth(uint16_t depth);
+
+    /// Send all the responses of the same instant to a client in a single packet (off by default)
+    void SetBatching(bool enable);
+
+    uint16_t GetConnectionCount() const;
+
+    /// Amount of requests answered with ServerDeviceBusy because a connection's queue was full
+    uint64_t GetBusyRequests() const;
+
+    /// Amount of requests dropped because their MBAP header was malformed
+    uint64_t GetMalformedRequests() const;
+
+    const ModbusBatcher &GetBatcher() const;
+
+private:
+    /// Serve the requests received from the client
+    void HandleRead(ns3::Ptr<ns3::Socket> socket);
+
+    /// Refuses new connections once the maximum amount of clients is reached
+    bool HandleConnectionRequest(ns3::Ptr<ns3::Socket> s, const ns3::Address &from);
+
+    void HandleAccept(ns3::Ptr<ns3::Socket> s, const ns3::Address &from);
+
+    /// Forget about a client once its connection is closed
+    void HandleClose(ns3::Ptr<ns3::Socket> s);
+
+    /// Bookkeeping for each accepted client
+    struct Connection
+    {
+        ns3::Address peer;     //!< Address of the client
+        ModbusStream input;    //!< Requests split across packets
+        uint64_t requests = 0; //!< Requests served
+    };
+
+    const char *m_Component;
+    std::string m_Name;
+    Handler m_Handler;
+    ns3::Ptr<ns3::Socket> m_Socket;                            //!< Listening socket
+    std::map<ns3::Ptr<ns3::Socket>, Connection> m_Connections; //!< Accepted clients
+    uint16_t m_MaxConnections = 16;
+    uint16_t m_QueueDepth = 32;
+    uint64_t m_BusyRequests = 0;
+    uint64_t m_MalformedRequests = 0;
+    ModbusBatcher m_Batcher; //!< Outbound buffer per client socket
+};
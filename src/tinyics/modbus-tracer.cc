@@ -0,0 +1,187 @@
+#include "modbus-tracer.h"
+
+#include "ns3/simulator.h"
+
+#include <iomanip>
+#include <limits>
+
+LatencyHistogram::LatencyHistogram()
+{
+    Reset();
+}
+
+uint16_t
+LatencyHistogram::IndexOf(uint64_t value)
+{
+    if (value < s_SubBuckets)
+        return value;
+
+    // Position of the most significant bit, picks the power of two
+    uint8_t msb = 63 - __builtin_clzll(value);
+    uint8_t shift = msb - s_SubBucketBits;
+
+    uint32_t idx = (shift + 1) * s_SubBuckets + ((value >> shift) & (s_SubBuckets - 1));
+
+    return std::min<uint32_t>(idx, s_Magnitudes * s_SubBuckets - 1);
+}
+
+uint64_t
+LatencyHistogram::UpperBoundOf(uint16_t idx)
+{
+    uint16_t magnitude = idx / s_SubBuckets;
+    uint64_t sub = idx % s_SubBuckets;
+
+    if (magnitude == 0)
+        return sub;
+
+    return ((s_SubBuckets + sub + 1) << (magnitude - 1)) - 1;
+}
+
+void
+LatencyHistogram::Record(uint64_t valueUs)
+{
+    m_Counts[IndexOf(valueUs)]++;
+    m_Count++;
+    m_Sum += valueUs;
+
+    if (valueUs < m_Min)
+        m_Min = valueUs;
+
+    if (valueUs > m_Max)
+        m_Max = valueUs;
+}
+
+void
+LatencyHistogram::Reset()
+{
+    m_Counts.fill(0);
+    m_Count = 0;
+    m_Min = std::numeric_limits<uint64_t>::max();
+    m_Max = 0;
+    m_Sum = 0;
+}
+
+uint64_t
+LatencyHistogram::GetCount() const
+{
+    return m_Count;
+}
+
+uint64_t
+LatencyHistogram::GetMin() const
+{
+    return m_Count ? m_Min : 0;
+}
+
+uint64_t
+LatencyHistogram::GetMax() const
+{
+    return m_Max;
+}
+
+double
+LatencyHistogram::GetMean() const
+{
+    return m_Count ? m_Sum / m_Count : 0;
+}
+
+uint64_t
+LatencyHistogram::GetPercentile(double percentile) const
+{
+    if (m_Count == 0)
+        return 0;
+
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+
+    // Amount of values that should be at or below the percentile
+    uint64_t target = std::max<uint64_t>(1, percentile / 100.0 * m_Count + 0.5);
+
+    uint64_t seen = 0;
+    for (uint16_t i = 0; i < m_Counts.size(); i++)
+    {
+        seen += m_Counts[i];
+
+        if (seen >= target)
+            return std::min(UpperBoundOf(i), m_Max);
+    }
+
+    return m_Max;
+}
+
+void
+TransactionTracer::Enable(bool enable)
+{
+    m_Enabled = enable;
+
+    if (!enable)
+        m_Outstanding.clear();
+}
+
+void
+TransactionTracer::DoRequest(uint32_t rtu, uint16_t tid, MB_FunctionCode fc)
+{
+    m_Outstanding[MakeKey(rtu, tid)] = Outstanding{fc, ns3::Simulator::Now()};
+    m_Stats[Key(rtu, fc)].requests++;
+}
+
+void
+TransactionTracer::DoResponse(uint32_t rtu, uint16_t tid)
+{
+    auto it = m_Outstanding.find(MakeKey(rtu, tid));
+
+    // Response to a request we are not tracing (or that already timed out)
+    if (it == m_Outstanding.end())
+        return;
+
+    auto &stats = m_Stats[Key(rtu, it->second.fc)];
+    stats.responses++;
+    stats.latency.Record((ns3::Simulator::Now() - it->second.sent).GetMicroSeconds());
+
+    m_Outstanding.erase(it);
+}
+
+void
+TransactionTracer::DoTimeout(uint32_t rtu, uint16_t tid)
+{
+    auto it = m_Outstanding.find(MakeKey(rtu, tid));
+
+    if (it == m_Outstanding.end())
+        return;
+
+    m_Stats[Key(rtu, it->second.fc)].timeouts++;
+    m_Outstanding.erase(it);
+}
+
+const std::map<TransactionTracer::Key, TransactionStats> &
+TransactionTracer::GetStats() const
+{
+    return m_Stats;
+}
+
+void
+TransactionTracer::Reset()
+{
+    m_Outstanding.clear();
+    m_Stats.clear();
+}
+
+void
+TransactionTracer::Print(std::ostream &os) const
+{
+    os << std::setw(5) << "rtu" << std::setw(5) << "fc" << std::setw(10) << "requests"
+       << std::setw(10) << "responses" << std::setw(10) << "timeouts" << std::setw(10)
+       << "retries" << std::setw(12) << "exceptions" << std::setw(12) << "mean(us)"
+       << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)" << std::setw(12)
+       << "max(us)" << '\n';
+
+    for (const auto &[key, stats] : m_Stats)
+    {
+        os << std::setw(5) << key.first << std::setw(5) << (int)key.second << std::setw(10)
+           << stats.requests << std::setw(10) << stats.responses << std::setw(10)
+           << stats.timeouts << std::setw(10) << stats.retries << std::setw(12)
+           << stats.exceptions << std::setw(12) << std::fixed << std::setprecision(1)
+           << stats.latency.GetMean() << std::setw(12)
+           << stats.latency.GetPercentile(50) << std::setw(12) << stats.latency.GetPercentile(99)
+           << std::setw(12) << stats.latency.GetMax() << '\n';
+    }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+
+#include "ns3/nstime.h"
+
+#include "modbus.h"
+
+/**
+ * Latency histogram with HDR-style buckets.
+ *
+ * Values are grouped by their power of two and each power of two is split
+ * into s_SubBuckets linear sub-buckets, this keeps the relative error of
+ * any reported value under 1/s_SubBuckets while using a fixed amount of
+ * memory. Values are recorded in microseconds.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void Record(uint64_t valueUs);
+
+    void Reset();
+
+    uint64_t GetCount() const;
+    uint64_t GetMin() const;
+    uint64_t GetMax() const;
+    double GetMean() const;
+
+    /**
+     * Get the value at the given percentile (0-100)
+     *
+     * The returned value is the upper bound of the bucket holding the percentile.
+     */
+    uint64_t GetPercentile(double percentile) const;
+
+private:
+    static constexpr uint8_t s_SubBucketBits = 4;
+    static constexpr uint8_t s_SubBuckets = 1 << s_SubBucketBits;
+    static constexpr uint8_t s_Magnitudes = 40; //!< Up to 2^40us (~12 days)
+
+    static uint16_t IndexOf(uint64_t value);
+    static uint64_t UpperBoundOf(uint16_t idx);
+
+    std::array<uint64_t, s_Magnitudes * s_SubBuckets> m_Counts;
+    uint64_t m_Count;
+    uint64_t m_Min;
+    uint64_t m_Max;
+    double m_Sum;
+};
+
+/**
+ * Latency and outcome counters for a given RTU and function code
+ */
+struct TransactionStats
+{
+    uint64_t requests = 0;   //!< Requests sent
+    uint64_t responses = 0;  //!< Responses matched to a request
+    uint64_t timeouts = 0;   //!< Requests that never got a response in time
+    uint64_t retries = 0;    //!< Requests that were sent again after a timeout
+    uint64_t exceptions = 0; //!< Responses that were exception responses
+    LatencyHistogram latency;
+};
+
+/**
+ * Traces the Modbus transactions of a client.
+ *
+ * Each outstanding request is timestamped by (RTU, transaction id) and
+ * matched when the response arrives. Tracing is disabled by default, in which
+ * case every hook returns right away.
+ */
+class TransactionTracer
+{
+public:
+    using Key = std::pair<uint32_t, MB_FunctionCode>; //!< (RTU handle, function code)
+
+    void Enable(bool enable);
+
+    inline bool IsEnabled() const
+    {
+        return m_Enabled;
+    }
+
+    inline void OnRequest(uint32_t rtu, uint16_t tid, MB_FunctionCode fc)
+    {
+        if (m_Enabled)
+            DoRequest(rtu, tid, fc);
+    }
+
+    inline void OnResponse(uint32_t rtu, uint16_t tid)
+    {
+        if (m_Enabled)
+            DoResponse(rtu, tid);
+    }
+
+    inline void OnTimeout(uint32_t rtu, uint16_t tid)
+    {
+        if (m_Enabled)
+            DoTimeout(rtu, tid);
+    }
+
+    inline void OnRetry(uint32_t rtu, MB_FunctionCode fc)
+    {
+        if (m_Enabled)
+            m_Stats[Key(rtu, fc)].retries++;
+    }
+
+    inline void OnException(uint32_t rtu, MB_FunctionCode fc)
+    {
+        if (m_Enabled)
+            m_Stats[Key(rtu, fc)].exceptions++;
+    }
+
+    const std::map<Key, TransactionStats> &GetStats() const;
+
+    void Reset();
+
+    /// Print a summary table of the collected statistics
+    void Print(std::ostream &os) const;
+
+private:
+    struct Outstanding
+    {
+        MB_FunctionCode fc;
+        ns3::Time sent;
+    };
+
+    void DoRequest(uint32_t rtu, uint16_t tid, MB_FunctionCode fc);
+    void DoResponse(uint32_t rtu, uint16_t tid);
+    void DoTimeout(uint32_t rtu, uint16_t tid);
+
+    static inline uint64_t MakeKey(uint32_t rtu, uint16_t tid)
+    {
+        return (static_cast<uint64_t>(rtu) << 16) | tid;
+    }
+
+    bool m_Enabled = false;
+    std::unordered_map<uint64_t, Outstanding> m_Outstanding; //!< In-flight requests
+    std::map<Key, TransactionStats> m_Stats;
+};
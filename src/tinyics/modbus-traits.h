@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "modbus.h"
+
+/// Data image of the server that a function code reads or writes
+enum class MB_Image : uint8_t
+{
+    Coils,
+    DiscreteInputs,
+    InputRegisters,
+    None,
+};
+
+/**
+ * Static description of a Modbus function code.
+ *
+ * Both the server (request validation and dispatch) and the client
+ * (response decoding) look function codes up in the same table, so
+ * supporting a new function code starts by adding its entry here.
+ */
+struct MB_FunctionTraits
+{
+    bool supported = false;
+    bool write = false;               //!< Modifies the image instead of reading it
+    MB_Image image = MB_Image::None;  //!< Image targeted by the function code
+    uint8_t width = 0;                //!< Bits per element of the image
+    uint16_t maxCount = 0;            //!< Maximum elements per request
+    uint8_t requestSize = 0;          //!< Data bytes of the request (after the function code)
+    bool packed = false;              //!< Request ends with a byte count and packed values
+};
+
+/// Function codes are 7 bits wide, the highest bit flags exception responses
+#define MB_FUNCTION_CODES 128
+
+constexpr std::array<MB_FunctionTraits, MB_FUNCTION_CODES>
+MakeFunctionTraits()
+{
+    std::array<MB_FunctionTraits, MB_FUNCTION_CODES> traits{};
+
+    // Reads carry the start address and the amount of elements
+    traits[MB_FunctionCode::ReadCoils] = {true, false, MB_Image::Coils, 1, 2000, 4};
+    traits[MB_FunctionCode::ReadDiscreteInputs] =
+        {true, false, MB_Image::DiscreteInputs, 1, 2000, 4};
+    traits[MB_FunctionCode::ReadInputRegisters] =
+        {true, false, MB_Image::InputRegisters, 16, 125, 4};
+
+    // Single writes carry the address and the value
+    traits[MB_FunctionCode::WriteSingleCoil] = {true, true, MB_Image::Coils, 1, 1, 4};
+
+    // Multiple writes carry the start address, the amount of elements and the byte count
+    traits[MB_FunctionCode::WriteMultipleCoils] =
+        {true, true, MB_Image::Coils, 1, 1968, 5, true};
+
+    return traits;
+}
+
+inline constexpr std::array<MB_FunctionTraits, MB_FUNCTION_CODES> MB_TRAITS =
+    MakeFunctionTraits();
+
+/// Traits of the function code (the exception bit is ignored)
+constexpr const MB_FunctionTraits &
+GetFunctionTraits(uint8_t fc)
+{
+    return MB_TRAITS[fc & 0x7F];
+}
@@ -0,0 +1,234 @@
+#include "modbus-transaction.h"
+
+#include "ns3/simulator.h"
+
+TransactionManager::TransactionManager(TransactionTracer &tracer, ModbusBatcher &batcher)
+    : m_Tracer(tracer),
+      m_Batcher(batcher)
+{
+}
+
+TransactionManager::~TransactionManager()
+{
+    Clear();
+}
+
+void
+TransactionManager::SetTimeout(ns3::Time timeout)
+{
+    m_Timeout = timeout;
+}
+
+void
+TransactionManager::SetRetries(uint8_t retries)
+{
+    m_Retries = retries;
+}
+
+void
+TransactionManager::SetBusyDelay(ns3::Time delay)
+{
+    m_BusyDelay = delay;
+}
+
+void
+TransactionManager::SetWindow(uint16_t window)
+{
+    if (window == 0)
+        NS_FATAL_ERROR("The outstanding request window should allow at least one request");
+
+    m_Window = window;
+}
+
+void
+TransactionManager::SetDropCallback(ns3::Callback<void, size_t, MB_FunctionCode> drop)
+{
+    m_Drop = drop;
+}
+
+size_t
+TransactionManager::AddRTU(ns3::Ptr<ns3::Socket> socket, uint8_t uid)
+{
+    m_RTUs.emplace_back(socket, uid);
+    return m_RTUs.size() - 1;
+}
+
+void
+TransactionManager::Submit(size_t rtu, const Command &command)
+{
+    RTU &target = m_RTUs[rtu];
+
+    if (target.inFlight < m_Window)
+        Send(rtu, command);
+    else
+        target.queue.push_back(command);
+}
+
+void
+TransactionManager::Send(size_t rtu, const Command &command)
+{
+    RTU &target = m_RTUs[rtu];
+
+    // The window is smaller than the tid space, so there's always a free one
+    uint16_t tid = target.nextTid++;
+    while (m_InFlight.count(MakeKey(rtu, tid)))
+        tid = target.nextTid++;
+
+    m_Batcher.Queue(target.socket, command.Build(tid, target.uid));
+    m_Tracer.OnRequest(rtu, tid, command.GetFunctionCode());
+
+    auto [it, inserted] = m_InFlight.emplace(MakeKey(rtu, tid), Transaction(command));
+    it->second.timer =
+        ns3::Simulator::Schedule(m_Timeout, &TransactionManager::Expire, this, rtu, tid);
+
+    target.inFlight++;
+}
+
+bool
+TransactionManager::Complete(size_t rtu, uint16_t tid)
+{
+    auto it = m_InFlight.find(MakeKey(rtu, tid));
+
+    // Unknown transaction, e.g. it already timed out
+    if (it == m_InFlight.end())
+        return false;
+
+    m_Tracer.OnResponse(rtu, tid);
+
+    it->second.timer.Cancel();
+    m_InFlight.erase(it);
+
+    m_RTUs[rtu].inFlight--;
+    Drain(rtu);
+
+    return true;
+}
+
+bool
+TransactionManager::Defer(size_t rtu, uint16_t tid)
+{
+    auto it = m_InFlight.find(MakeKey(rtu, tid));
+
+    if (it == m_InFlight.end())
+        return false;
+
+    Transaction &transaction = it->second;
+
+    if (transaction.attempts > m_Retries)
+        return false;
+
+    transaction.attempts++;
+    m_Tracer.OnRetry(rtu, transaction.command.GetFunctionCode());
+
+    transaction.timer.Cancel();
+    transaction.timer =
+        ns3::Simulator::Schedule(m_BusyDelay, &TransactionManager::Resend, this, rtu, tid);
+
+    return true;
+}
+
+void
+TransactionManager::Resend(size_t rtu, uint16_t tid)
+{
+    auto it = m_InFlight.find(MakeKey(rtu, tid));
+
+    if (it == m_InFlight.end())
+        return;
+
+    Transaction &transaction = it->second;
+
+    // Same Transaction Identifier, a late answer to the previous attempt still completes it
+    m_Batcher.Queue(m_RTUs[rtu].socket, transaction.command.Build(tid, m_RTUs[rtu].uid));
+
+    transaction.timer =
+        ns3::Simulator::Schedule(m_Timeout, &TransactionManager::Expire, this, rtu, tid);
+}
+
+void
+TransactionManager::Expire(size_t rtu, uint16_t tid)
+{
+    auto it = m_InFlight.find(MakeKey(rtu, tid));
+
+    if (it == m_InFlight.end())
+        return;
+
+    Transaction &transaction = it->second;
+    const Command &command = transaction.command;
+
+    if (transaction.attempts <= m_Retries)
+    {
+        transaction.attempts++;
+        m_Tracer.OnRetry(rtu, command.GetFunctionCode());
+
+        Resend(rtu, tid);
+        return;
+    }
+
+    m_Tracer.OnTimeout(rtu, tid);
+
+    MB_FunctionCode fc = command.GetFunctionCode();
+
+    m_InFlight.erase(it);
+    m_RTUs[rtu].inFlight--;
+
+    if (!m_Drop.IsNull())
+        m_Drop(rtu, fc);
+
+    Drain(rtu);
+}
+
+void
+TransactionManager::Drain(size_t rtu)
+{
+    RTU &target = m_RTUs[rtu];
+
+    while (target.inFlight < m_Window && !target.queue.empty())
+    {
+        Command command = target.queue.front();
+        target.queue.pop_front();
+
+        Send(rtu, command);
+    }
+}
+
+void
+TransactionManager::Clear()
+{
+    for (auto &[key, transaction] : m_InFlight)
+        transaction.timer.Cancel();
+
+    m_InFlight.clear();
+
+    // The connections are closed, they are added again when the client restarts
+    m_RTUs.clear();
+}
+
+size_t
+TransactionManager::GetRTUCount() const
+{
+    return m_RTUs.size();
+}
+
+uint16_t
+TransactionManager::GetInFlight(size_t rtu) const
+{
+    return m_RTUs[rtu].inFlight;
+}
+
+uint16_t
+TransactionManager::GetQueued(size_t rtu) const
+{
+    return m_RTUs[rtu].queue.size();
+}
+
+uint16_t
+TransactionManager::GetNextTransactionId(size_t rtu) const
+{
+    return m_RTUs[rtu].nextTid;
+}
+
+void
+TransactionManager::SetNextTransactionId(size_t rtu, uint16_t tid)
+{
+    m_RTUs[rtu].nextTid = tid;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/socket.h"
+
+#include "modbus-batcher.h"
+#include "modbus-command.h"
+#include "modbus-tracer.h"
+
+/**
+ * Table of the in-flight transactions of a Modbus client.
+ *
+ * Requests are sent right away while their RTU has a free slot in its
+ * outstanding window, otherwise they wait in a FIFO queue for that RTU.
+ * Every request in flight has a deadline, when it expires the request is
+ * sent again until it runs out of retries and is dropped. Requests the
+ * server was too busy to serve are sent again after a delay, which also
+ * counts as a retry.
+ *
+ * Each RTU has its own connection and, as in Modbus TCP, its own sequence
+ * of transaction ids. Transactions are identified by the RTU and the tid, and
+ * a tid still in flight is skipped when the sequence wraps around.
+ */
+class TransactionManager
+{
+public:
+    TransactionManager(TransactionTracer &tracer, ModbusBatcher &batcher);
+    ~TransactionManager();
+
+    /// Time to wait for a response before retrying the request
+    void SetTimeout(ns3::Time timeout);
+
+    /// Amount of times a request is sent again after timing out (or a busy answer)
+    void SetRetries(uint8_t retries);
+
+    /// Time to wait before sending again a request answered with ServerDeviceBusy
+    void SetBusyDelay(ns3::Time delay);
+
+    /// Maximum amount of requests in flight per RTU
+    void SetWindow(uint16_t window);
+
+    /// Called with the RTU and function code of the requests that ran out of retries
+    void SetDropCallback(ns3::Callback<void, size_t, MB_FunctionCode> drop);
+
+    /**
+     * Register a new RTU, returns the index used to submit requests to it
+     *
+     * \param socket connection to the RTU
+     * \param uid unit id put in the requests sent through the connection
+     */
+    size_t AddRTU(ns3::Ptr<ns3::Socket> socket, uint8_t uid);
+
+    /// Send the command to the RTU or queue it if the RTU's window is full
+    void Submit(size_t rtu, const Command &command);
+
+    /**
+     * Mark the transaction of the RTU as completed.
+     *
+     * returns false if the transaction was not in flight for that RTU (e.g.
+     * a late response to a request that already timed out)
+     */
+    bool Complete(size_t rtu, uint16_t tid);
+
+    /**
+     * The server answered the transaction of the RTU with ServerDeviceBusy,
+     * send it again after the busy delay.
+     *
+     * returns false if the transaction was not in flight or ran out of
+     * retries, then it should be completed like any other answer
+     */
+    bool Defer(size_t rtu, uint16_t tid);
+
+    /// Drop every transaction in flight or queued and forget the RTUs
+    void Clear();
+
+    /// Amount of RTUs registered
+    size_t GetRTUCount() const;
+
+    uint16_t GetInFlight(size_t rtu) const;
+
+    uint16_t GetQueued(size_t rtu) const;
+
+    /// Transaction id the next request to the RTU starts looking from
+    uint16_t GetNextTransactionId(size_t rtu) const;
+
+    void SetNextTransactionId(size_t rtu, uint16_t tid);
+
+private:
+    struct Transaction
+    {
+        Transaction(const Command &command)
+            : command(command)
+        {
+        }
+
+        Command command;
+        uint8_t attempts = 1;
+        ns3::EventId timer;
+    };
+
+    struct RTU
+    {
+        RTU(ns3::Ptr<ns3::Socket> socket, uint8_t uid)
+            : socket(socket),
+              uid(uid)
+        {
+        }
+
+        ns3::Ptr<ns3::Socket> socket;
+        uint8_t uid;
+        uint16_t inFlight = 0;
+        uint16_t nextTid = 0;     //!< Next Transaction Identifier on the connection
+        std::deque<Command> queue;
+    };
+
+    void Send(size_t rtu, const Command &command);
+
+    void Expire(size_t rtu, uint16_t tid);
+
+    /// Send the request of the transaction again and restart its deadline
+    void Resend(size_t rtu, uint16_t tid);
+
+    /// Fill the RTU's window with queued requests
+    void Drain(size_t rtu);
+
+    static inline uint64_t MakeKey(size_t rtu, uint16_t tid)
+    {
+        return (static_cast<uint64_t>(rtu) << 16) | tid;
+    }
+
+    ns3::Time m_Timeout = ns3::Seconds(1.0);
+    uint8_t m_Retries = 2;
+    ns3::Time m_BusyDelay = ns3::MilliSeconds(10);
+    uint16_t m_Window = 16;
+    std::vector<RTU> m_RTUs;                                //!< Window and queue per RTU
+    std::unordered_map<uint64_t, Transaction> m_InFlight;   //!< In-flight requests by RTU and tid
+    ns3::Callback<void, size_t, MB_FunctionCode> m_Drop;
+    TransactionTracer &m_Tracer;
+    ModbusBatcher &m_Batcher; //!< Requests sent in the same instant share a packet
+};
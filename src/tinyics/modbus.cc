@@ -1,4 +1,5 @@
 #include "modbus.h"
+#include "modbus-traits.h"
 #include "utils.h"
 
 ModbusADU::ModbusADU()
@@ -8,22 +9,28 @@ ModbusADU::ModbusADU()
     SetInitialValues();
 }
 
-ModbusADU::ModbusADU(const uint8_t *buff, uint16_t start, uint16_t finish)
+ModbusADU::ModbusADU(const uint8_t *buff, uint32_t start, uint32_t finish)
 {
-    if (finish < start)
+    // Not even a header, keep an empty one (length field 0) for IsValidFrame to reject
+    if (finish < start || finish - start + 1 < MB_BASE_SZ)
     {
-        NS_FATAL_ERROR_NO_MSG();
+        m_Size = MB_BASE_SZ;
+        m_Bytes = new uint8_t[m_Size]();
+        return;
     }
+
     m_Size = finish - start + 1;
+    m_Bytes = new uint8_t[m_Size];
 
-    if (m_Size < MB_BASE_SZ)
-    {
-        NS_FATAL_ERROR("Modbus Application Data Unit should be at least" << MB_BASE_SZ << "Bytes");
-    }
+    memcpy(m_Bytes, buff + start, m_Size);
+}
 
+ModbusADU::ModbusADU(const ModbusADU& other)
+{
+    m_Size = other.m_Size;
     m_Bytes = new uint8_t[m_Size];
 
-    memcpy(m_Bytes, buff + start, m_Size);
+    memcpy(m_Bytes, other.m_Bytes, m_Size);
 }
 
 ModbusADU::ModbusADU(ModbusADU&& other) noexcept
@@ -43,19 +50,29 @@ ModbusADU::~ModbusADU()
 std::vector<ModbusADU>
 ModbusADU::GetModbusADUs(const ns3::Ptr<ns3::Packet>& packet)
 {
+    // Too short to hold an ADU, drop it instead of aborting the simulation
     if (packet->GetSize() < MB_BASE_SZ)
-    {
-        NS_FATAL_ERROR("Data was not recognize as a Modbus ADU packet");
-    }
-
-    std::vector<ModbusADU> adus;
+        return std::vector<ModbusADU>();
 
     uint32_t dataStreamSize = packet->GetSize();
     uint8_t *dataStream = new uint8_t[dataStreamSize];
     packet->CopyData(dataStream, dataStreamSize);
 
+    uint32_t consumed;
+    std::vector<ModbusADU> adus = GetModbusADUs(dataStream, dataStreamSize, consumed);
+
+    delete[] dataStream;
+
+    return adus;
+}
+
+std::vector<ModbusADU>
+ModbusADU::GetModbusADUs(const uint8_t* dataStream, uint32_t dataStreamSize, uint32_t& consumed)
+{
+    std::vector<ModbusADU> adus;
+
     // Start and finish of a single Modbus ADU
-    uint16_t start=0, finish;
+    uint32_t start=0, finish;
 
     // While the data stream is large enough to read the length field
     while (start + LENGTH_FIELD_POS + 1 < dataStreamSize)
@@ -65,6 +82,14 @@ ModbusADU::GetModbusADUs(const ns3::Ptr<ns3::Packet>& packet)
             dataStream[start + LENGTH_FIELD_POS + 1]
         );
 
+        // The framing of the stream is lost, there's no way to find the
+        // start of the next ADU so the rest of the stream is discarded
+        if (length < 2 || length > MB_MAX_LENGTH)
+        {
+            start = dataStreamSize;
+            break;
+        }
+
         finish = (start + MB_BASE_SZ + length - 2) - 1;
 
         if (finish < dataStreamSize)
@@ -80,11 +105,35 @@ ModbusADU::GetModbusADUs(const ns3::Ptr<ns3::Packet>& packet)
             break;
         }
     }
-    delete[] dataStream;
+
+    consumed = start;
 
     return adus;
 }
 
+std::vector<ModbusADU>
+ModbusStream::Read(const ns3::Ptr<ns3::Packet>& packet)
+{
+    size_t pending = m_Buffer.size();
+
+    m_Buffer.resize(pending + packet->GetSize());
+    packet->CopyData(m_Buffer.data() + pending, packet->GetSize());
+
+    uint32_t consumed;
+    std::vector<ModbusADU> adus =
+        ModbusADU::GetModbusADUs(m_Buffer.data(), m_Buffer.size(), consumed);
+
+    m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + consumed);
+
+    return adus;
+}
+
+void
+ModbusStream::Clear()
+{
+    m_Buffer.clear();
+}
+
 ModbusADU& ModbusADU::operator=(ModbusADU source)
 {
     if (m_Size != source.m_Size)
@@ -215,6 +264,12 @@ ModbusADU::ToPacket() const
     return ns3::Create<ns3::Packet>(m_Bytes, m_Size);
 }
 
+void
+ModbusADU::AppendTo(std::vector<uint8_t>& buffer) const
+{
+    buffer.insert(buffer.end(), m_Bytes, m_Bytes + m_Size);
+}
+
 void
 ModbusADU::SetInitialValues()
 {
@@ -232,7 +287,7 @@ ModbusADU::SetInitialValues()
 }
 
 uint8_t
-ModbusADU::GetDataByte(uint8_t idx) const
+ModbusADU::GetDataByte(uint16_t idx) const
 {
     if (idx >= GetLengthField() - 2)
     {
@@ -243,3 +298,72 @@ ModbusADU::GetDataByte(uint8_t idx) const
     return m_Bytes[MB_BASE_SZ + idx];
 }
 
+
+bool
+ModbusADU::IsValidFrame() const
+{
+    if (m_Size < MB_BASE_SZ)
+        return false;
+
+    uint16_t protocol = CombineUint8(m_Bytes[PROTOCOL_ID_POS], m_Bytes[PROTOCOL_ID_POS + 1]);
+    uint16_t length = GetLengthField();
+    uint8_t uid = GetUnitID();
+
+    // Unit ids 248 to 254 are reserved
+    return protocol == 0 && length >= 2 && length <= MB_MAX_LENGTH &&
+           m_Size == length + UNIT_ID_POS && (uid < 248 || uid == 255);
+}
+
+MB_ExceptionCode
+ModbusADU::ValidateRequest() const
+{
+    const MB_FunctionTraits &traits = GetFunctionTraits(m_Bytes[FUNCTION_CODE_POS]);
+
+    if (!traits.supported)
+        return MB_ExceptionCode::IllegalFunction;
+
+    // Amount of data bytes after the function code
+    uint16_t size = GetLengthField() - 2;
+
+    if (traits.packed)
+    {
+        if (size < traits.requestSize)
+            return MB_ExceptionCode::IllegalDataValue;
+
+        // The packed values must be exactly as many as announced
+        uint16_t count = GetDataWordUnchecked(2);
+        uint8_t bytes = GetDataByteUnchecked(4);
+
+        bool valid = count >= 1 && count <= traits.maxCount &&
+                     bytes == (count * traits.width + 7) / 8 && size == traits.requestSize + bytes;
+
+        return valid ? MB_ExceptionCode::NoException : MB_ExceptionCode::IllegalDataValue;
+    }
+
+    if (size != traits.requestSize)
+        return MB_ExceptionCode::IllegalDataValue;
+
+    uint16_t value = GetDataWordUnchecked(2);
+
+    // Single writes carry a value, single coil writes only take ON (0xFF00) or OFF (0x0000)
+    if (traits.write)
+        return (traits.width != 1 || value == 0x0000 || value == 0xFF00)
+                   ? MB_ExceptionCode::NoException
+                   : MB_ExceptionCode::IllegalDataValue;
+
+    return (value >= 1 && value <= traits.maxCount) ? MB_ExceptionCode::NoException
+                                                    : MB_ExceptionCode::IllegalDataValue;
+}
+
+ModbusADU
+ModbusADU::MakeException(MB_ExceptionCode code) const
+{
+    ModbusADU response;
+    CopyBase(*this, response);
+
+    // The exception is flagged by the highest bit of the function code
+    response.m_Bytes[FUNCTION_CODE_POS] = m_Bytes[FUNCTION_CODE_POS] | 0x80;
+    response.SetData(std::vector<uint8_t>{static_cast<uint8_t>(code)});
+
+    return response;
+}
@@ -18,6 +18,9 @@
 #define FUNCTION_CODE_POS  7
 #define DATA_POS           8
 
+// Largest value of the length field (unit id and a PDU of 253 bytes)
+#define MB_MAX_LENGTH 254
+
 enum MB_FunctionCode
 {
     ReadCoils = 1,
@@ -26,6 +29,20 @@ enum MB_FunctionCode
     ReadInputRegisters = 4,
     WriteSingleCoil = 5,
     //WriteSingleHoldingRegister = 6, won't be supported yet
+    WriteMultipleCoils = 15,
+};
+
+/// Codes sent back in a Modbus exception response
+enum MB_ExceptionCode
+{
+    NoException = 0,
+    IllegalFunction = 1,     //!< Function code not supported by the server
+    IllegalDataAddress = 2,  //!< Address range not available in the server
+    IllegalDataValue = 3,    //!< Malformed request or value out of range
+    ServerDeviceFailure = 4, //!< The server failed while executing the request
+    ServerDeviceBusy = 6,    //!< The server is busy, the client should retry later
+    GatewayPathUnavailable = 10,     //!< The gateway has no path to the target
+    GatewayTargetFailedToRespond = 11, //!< The target behind the gateway didn't answer
 };
 
 /**
@@ -42,6 +59,7 @@ enum MB_FunctionCode
 class ModbusADU {
 public:
     ModbusADU();
+    ModbusADU(const ModbusADU& other);
     ModbusADU(ModbusADU&& other) noexcept;
     ~ModbusADU();
 
@@ -60,9 +78,50 @@ public:
     uint16_t GetLengthField() const;
     uint8_t GetUnitID() const;
     MB_FunctionCode GetFunctionCode() const;
-    uint8_t GetDataByte(uint8_t idx) const;
+    uint8_t GetDataByte(uint16_t idx) const;
     uint32_t GetBufferSize() const;
 
+    /**
+     * Data accessors without bounds checks, only for ADUs that went through
+     * IsValidFrame and ValidateRequest (or an equivalent check on the size).
+     */
+    inline uint8_t GetDataByteUnchecked(uint16_t idx) const
+    {
+        return m_Bytes[DATA_POS + idx];
+    }
+
+    /// Data bytes of the ADU, for bulk copies
+    inline const uint8_t *GetDataUnchecked() const
+    {
+        return m_Bytes + DATA_POS;
+    }
+
+    /// Big endian 16 bit value starting at the data byte `idx`
+    inline uint16_t GetDataWordUnchecked(uint16_t idx) const
+    {
+        return (m_Bytes[DATA_POS + idx] << 8) | m_Bytes[DATA_POS + idx + 1];
+    }
+
+    /**
+     * Check the MBAP header once: protocol id 0, a length field within
+     * bounds that matches the size of the ADU and a non reserved unit id.
+     *
+     * Frames that fail this check can't be answered reliably and should be
+     * dropped.
+     */
+    bool IsValidFrame() const;
+
+    /**
+     * Check that a valid frame is a well formed request: a supported
+     * function code, with the data size and values it expects.
+     *
+     * returns the exception code to answer with, or NoException
+     */
+    MB_ExceptionCode ValidateRequest() const;
+
+    /// Build the exception response to this request
+    ModbusADU MakeException(MB_ExceptionCode code) const;
+
     /**
      * Gets the ADUs contained in the packet.
      *
@@ -74,15 +133,31 @@ public:
      */
     static std::vector<ModbusADU> GetModbusADUs(const ns3::Ptr<ns3::Packet>& packet);
 
+    /**
+     * Gets the complete ADUs at the start of a byte stream.
+     *
+     * `consumed` is set to the amount of bytes used by those ADUs, the rest
+     * belong to an ADU that hasn't been fully received yet.
+     */
+    static std::vector<ModbusADU> GetModbusADUs(const uint8_t* stream,
+                                                uint32_t size,
+                                                uint32_t& consumed);
+
     /**
      * Build a ns3::Packet from the byte buffer, this is safer than
      * passing the pointer around.
      */
     ns3::Ptr<ns3::Packet> ToPacket() const;
 
+    /**
+     * Serialize the ADU at the end of the buffer, used to send several
+     * ADUs back to back in the same packet.
+     */
+    void AppendTo(std::vector<uint8_t>& buffer) const;
+
 
 private:
-    ModbusADU(const uint8_t* buff, uint16_t start, uint16_t finish);
+    ModbusADU(const uint8_t* buff, uint32_t start, uint32_t finish);
 
     void SetLengthField(uint16_t length);
 
@@ -90,7 +165,26 @@ private:
     
     // TODO: Is this the best way of storing the data?
     uint8_t *m_Bytes;   //< data in the ADU
-    uint8_t m_Size;     //< size of the ADU byte buffer
+    uint16_t m_Size;    //< size of the ADU byte buffer
+};
+
+/**
+ * \brief Reassembles the ADUs received on a Modbus TCP connection
+ *
+ * TCP doesn't keep the boundaries of what was sent: a packet can carry
+ * several ADUs and an ADU can be split across packets. The bytes of an
+ * ADU that hasn't been fully received are kept until the rest arrives.
+ */
+class ModbusStream {
+public:
+    /// Append the bytes of the packet and take the ADUs they complete
+    std::vector<ModbusADU> Read(const ns3::Ptr<ns3::Packet>& packet);
+
+    /// Discard the bytes of the incomplete ADU
+    void Clear();
+
+private:
+    std::vector<uint8_t> m_Buffer; //!< bytes that don't form a full ADU yet
 };
 
 // TODO: Is template the best way to do this? Maybe two definitions with
@@ -100,7 +194,7 @@ void
 ModbusADU::SetData(const std::vector<T>& data)
 {
     // The amount of data that will be inserted in the packet
-    uint8_t dataSize;
+    size_t dataSize;
 
     if (std::is_same<T, uint8_t>::value)
     {
@@ -115,6 +209,12 @@ ModbusADU::SetData(const std::vector<T>& data)
         NS_FATAL_ERROR("Can only load uint8_t or uint16_t into Modbus ADU");
     }
 
+    // The length field also counts the unit id and the function code
+    if (dataSize + 2 > MB_MAX_LENGTH)
+    {
+        NS_FATAL_ERROR("Data of " << dataSize << " bytes doesn't fit in a Modbus ADU");
+    }
+
     if (m_Size != dataSize + MB_BASE_SZ)
     {
         m_Size = dataSize + MB_BASE_SZ;
@@ -135,7 +235,7 @@ ModbusADU::SetData(const std::vector<T>& data)
     }
 
 
-    uint8_t i = 0;
+    uint16_t i = 0;
     if (std::is_same<T, uint16_t>::value)
     {
         for (auto byte : data)
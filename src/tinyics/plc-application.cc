@@ -4,6 +4,7 @@
 
 #include "industrial-plant.h"
 #include "modbus.h"
+#include "profiler.h"
 #include "utils.h"
 
 ns3::TypeId
@@ -17,14 +18,14 @@ PlcApplication::GetTypeId()
 }
 
 PlcApplication::PlcApplication(const char *name)
-    : IndustrialApplication(name)
+    : IndustrialApplication(name),
+      m_Server("plc_read", name, ns3::MakeCallback(&PlcApplication::ProcessRequest, this))
 {
     IndustrialPlant::RegisterPLC(this);
 }
 
 PlcApplication::~PlcApplication()
 {
-    m_Socket = nullptr;
     m_IndustrialProcess = nullptr;
 }
 
@@ -37,62 +38,100 @@ PlcApplication::DoDispose()
 void
 PlcApplication::StartApplication()
 {
-    if (!m_Socket)
-    {
-        // Create TCP socket
-        ns3::TypeId tid = ns3::TypeId::LookupByName("ns3::TcpSocketFactory");
-        m_Socket = ns3::Socket::CreateSocket(GetNode(), tid);
-
-        // Bind the socket to the local address
-        ns3::InetSocketAddress local = ns3::InetSocketAddress(ns3::Ipv4Address::GetAny(), s_Port);
-        if (m_Socket->Bind(local) == -1)
-        {
-            NS_FATAL_ERROR("Failed to bind socket");
-        }
-    }
-
-    m_Socket->Listen();
-    m_Socket->SetAcceptCallback(
-        ns3::MakeNullCallback<bool, ns3::Ptr<ns3::Socket>, const ns3::Address &>(),
-        MakeCallback(&PlcApplication::HandleAccept, this));
+    m_Server.Start(GetNode(), s_Port);
 }
 
 void
 PlcApplication::StopApplication()
 {
-    if (m_Socket)
-    {
-        m_Socket->Close();
-        m_Socket->SetRecvCallback(ns3::MakeNullCallback<void, ns3::Ptr<ns3::Socket>>());
-    }
+    m_Server.Stop();
 }
 
 void
-PlcApplication::HandleAccept(ns3::Ptr<ns3::Socket> s, const ns3::Address &from)
+PlcApplication::SetMaxConnections(uint16_t max)
 {
-    s->SetRecvCallback(MakeCallback(&PlcApplication::HandleRead, this));
+    m_Server.SetMaxConnections(max);
 }
 
 void
-PlcApplication::HandleRead(ns3::Ptr<ns3::Socket> socket)
+PlcApplication::SetQueueDepth(uint16_t depth)
+{
+    m_Server.SetQueueDepth(depth);
+}
+
+uint16_t
+PlcApplication::GetConnectionCount() const
+{
+    return m_Server.GetConnectionCount();
+}
+
+uint64_t
+PlcApplication::GetBusyRequests() const
+{
+    return m_Server.GetBusyRequests();
+}
+
+uint64_t
+PlcApplication::GetMalformedRequests() const
+{
+    return m_Server.GetMalformedRequests() + m_MalformedRequests;
+}
+
+void
+PlcApplication::SetBatching(bool enable)
+{
+    m_Server.SetBatching(enable);
+}
+
+const ModbusBatcher &
+PlcApplication::GetBatcher() const
 {
-    ns3::Ptr<ns3::Packet> packet;
-    ns3::Address from;
-    while ((packet = socket->RecvFrom(from)))
+    return m_Server.GetBatcher();
+}
+
+void
+PlcApplication::ProcessRequest(const ModbusADU &adu, std::vector<ModbusADU> &responses)
+{
+    // Malformed frames can't be answered reliably, drop them
+    if (!adu.IsValidFrame())
+    {
+        m_MalformedRequests++;
+        return;
+    }
+
+    MB_ExceptionCode code = adu.ValidateRequest();
+    if (code != MB_ExceptionCode::NoException)
     {
-        if (ns3::InetSocketAddress::IsMatchingType(from))
-        {
-            for (const ModbusADU &adu : ModbusADU::GetModbusADUs(packet))
-            {
-                MB_FunctionCode fc = adu.GetFunctionCode();
-
-                if (fc == MB_FunctionCode::ReadCoils || fc == MB_FunctionCode::WriteSingleCoil)
-                    RequestProcessor::Execute(fc, socket, from, adu, m_Out);
-                else
-                    RequestProcessor::Execute(fc, socket, from, adu, m_In);
-            }
-        }
+        responses.push_back(adu.MakeException(code));
+        return;
     }
+
+    MB_FunctionCode fc = adu.GetFunctionCode();
+
+    // Coils live in the output image, inputs and input registers in the input image
+    PlcState &state = GetFunctionTraits(fc).image == MB_Image::Coils ? m_Out : m_In;
+
+    RequestProcessor::Execute(fc, adu, state, responses);
+}
+
+void
+PlcApplication::Serialize(SnapshotWriter &writer) const
+{
+    m_In.Serialize(writer);
+    m_Out.Serialize(writer);
+
+    writer.WriteString(m_IndustrialProcess ? m_IndustrialProcess->Serialize() : std::string());
+}
+
+void
+PlcApplication::Deserialize(SnapshotReader &reader)
+{
+    m_In.Deserialize(reader);
+    m_Out.Deserialize(reader);
+
+    std::string process = reader.ReadString();
+    if (m_IndustrialProcess && !process.empty())
+        m_IndustrialProcess->Deserialize(process);
 }
 
 void
@@ -105,5 +144,6 @@ PlcApplication::LinkProcess(std::shared_ptr<IndustrialProcess> ip, uint8_t prior
 void
 PlcApplication::DoUpdate()
 {
+    TINYICS_PROFILE_SCOPE("plc_logic", GetName());
     Update(&m_In, &m_Out);
 }
@@ -6,6 +6,7 @@
 #include "industrial-application.h"
 #include "industrial-process.h"
 #include "modbus-request.h"
+#include "modbus-server.h"
 
 namespace ns3
 {
@@ -39,6 +40,43 @@ public:
     {
     }
 
+    /// Maximum amount of clients (SCADAs, HMIs, historians) connected at the same time
+    void SetMaxConnections(uint16_t max);
+
+    /**
+     * Maximum amount of requests served per connection at once, the rest of
+     * the requests pipelined by the client are answered with ServerDeviceBusy
+     */
+    void SetQueueDepth(uint16_t depth);
+
+    uint16_t GetConnectionCount() const;
+
+    /// Amount of requests answered with ServerDeviceBusy because a connection's queue was full
+    uint64_t GetBusyRequests() const;
+
+    /// Amount of requests dropped because their MBAP header was malformed
+    uint64_t GetMalformedRequests() const;
+
+    /// Send all the responses of the same instant to a client in a single packet (off by default)
+    void SetBatching(bool enable);
+
+    const ModbusBatcher &GetBatcher() const;
+
+    /**
+     * Run the request on the state it targets and append the response.
+     *
+     * Malformed frames are dropped and malformed requests are answered with
+     * an exception response. Used for the requests received by the PLC's
+     * socket, and by gateways that inject requests from outside the
+     * simulated network.
+     */
+    void ProcessRequest(const ModbusADU &adu, std::vector<ModbusADU> &responses);
+
+    /// Write the PLC's state and the state of its process into the snapshot
+    void Serialize(SnapshotWriter &writer) const;
+
+    void Deserialize(SnapshotReader &reader);
+
 protected:
     void DoDispose() override;
 
@@ -46,26 +84,15 @@ private:
     void StartApplication() override;
     void StopApplication() override;
 
-    /*
-     * Processes each packet received from the socket using Modbus.
-     *
-     * Note: There are a lot of verifications that are currently not
-     * being considered. And exceptions that are currently not being
-     * thrown.
-     */
-    void HandleRead(ns3::Ptr<ns3::Socket> socket);
-
-    /// Accept callback for the socket
-    void HandleAccept(ns3::Ptr<ns3::Socket> s, const ns3::Address &from);
-
     /// Do the state update
     void DoUpdate();
 
     static constexpr uint16_t s_Port = 502; //!< Port on which we listen for incoming packets
-    ns3::Ptr<ns3::Socket> m_Socket;         //!< IPv4 Sockets
+    ModbusServer m_Server;                  //!< Clients connected to the PLC
     PlcState m_In;                          //!< State of the PLC input ports
     PlcState m_Out;                         //!< State of the PLC out ports
     std::shared_ptr<IndustrialProcess> m_IndustrialProcess; //!< process being controlled
+    uint64_t m_MalformedRequests = 0;       //!< Gateway requests dropped for a bad header
 
     friend class IndustrialNetworkBuilder;
     friend class IndustrialPlant;
@@ -0,0 +1,129 @@
+#include "plc-host.h"
+
+ns3::TypeId
+PlcHost::GetTypeId()
+{
+    static ns3::TypeId tid = ns3::TypeId("PlcHost")
+        .SetParent<Application>()
+        .SetGroupName("Applications");
+
+    return tid;
+}
+
+PlcHost::PlcHost(const char *name)
+    : IndustrialApplication(name),
+      m_Server("plc_host_read", name, ns3::MakeCallback(&PlcHost::Dispatch, this))
+{
+}
+
+void
+PlcHost::DoDispose()
+{
+    m_Units.fill(nullptr);
+    Application::DoDispose();
+}
+
+void
+PlcHost::AddUnit(uint8_t uid, ns3::Ptr<PlcApplication> plc)
+{
+    if (uid == 0 || uid > 247)
+        NS_FATAL_ERROR("Invalid unit id " << (int)uid << " for PLC host " << GetName());
+
+    if (m_Units[uid])
+        NS_FATAL_ERROR("Unit id " << (int)uid << " already in use on PLC host " << GetName());
+
+    if (plc->GetNode())
+        NS_FATAL_ERROR("PLC " << plc->GetName() << " is already in the network, it can't be "
+                              << "hosted by " << GetName());
+
+    m_Units[uid] = plc;
+    m_UnitCount++;
+}
+
+ns3::Ptr<PlcApplication>
+PlcHost::GetUnit(uint8_t uid) const
+{
+    return m_Units[uid];
+}
+
+uint16_t
+PlcHost::GetUnitCount() const
+{
+    return m_UnitCount;
+}
+
+void
+PlcHost::SetMaxConnections(uint16_t max)
+{
+    m_Server.SetMaxConnections(max);
+}
+
+void
+PlcHost::SetQueueDepth(uint16_t depth)
+{
+    m_Server.SetQueueDepth(depth);
+}
+
+uint16_t
+PlcHost::GetConnectionCount() const
+{
+    return m_Server.GetConnectionCount();
+}
+
+uint64_t
+PlcHost::GetBusyRequests() const
+{
+    return m_Server.GetBusyRequests();
+}
+
+uint64_t
+PlcHost::GetUnroutedRequests() const
+{
+    return m_UnroutedRequests;
+}
+
+uint64_t
+PlcHost::GetMalformedRequests() const
+{
+    return m_Server.GetMalformedRequests();
+}
+
+void
+PlcHost::SetBatching(bool enable)
+{
+    m_Server.SetBatching(enable);
+}
+
+const ModbusBatcher &
+PlcHost::GetBatcher() const
+{
+    return m_Server.GetBatcher();
+}
+
+void
+PlcHost::StartApplication()
+{
+    m_Server.Start(GetNode(), s_Port);
+}
+
+void
+PlcHost::StopApplication()
+{
+    m_Server.Stop();
+}
+
+void
+PlcHost::Dispatch(const ModbusADU &adu, std::vector<ModbusADU> &responses)
+{
+    const ns3::Ptr<PlcApplication> &unit = m_Units[adu.GetUnitID()];
+
+    // Nothing behind the unit id, answer like a real gateway would
+    if (!unit)
+    {
+        m_UnroutedRequests++;
+        responses.push_back(adu.MakeException(MB_ExceptionCode::GatewayPathUnavailable));
+        return;
+    }
+
+    unit->ProcessRequest(adu, responses);
+}
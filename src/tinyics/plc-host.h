@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+
+#include "plc-application.h"
+
+/**
+ * Many logical PLCs served from a single node.
+ *
+ * Racks and gateways front several devices from one Modbus TCP endpoint,
+ * telling them apart by the unit id of each request. The host serves
+ * port 502 of its node (see ModbusServer) and hands each request to the
+ * PLC registered for its unit id, requests for unknown unit ids are
+ * answered with the GatewayPathUnavailable exception.
+ *
+ * The hosted PLCs are not added to the network themselves, so they don't
+ * pay for a node, an internet stack and a CSMA device each. They keep
+ * their own state, logic and linked process, which the plant updates as
+ * usual. SCADAs reach them with AddRTU(host address, unit id).
+ */
+class PlcHost : public IndustrialApplication
+{
+public:
+    static ns3::TypeId GetTypeId();
+
+    PlcHost(const char *name);
+
+    /**
+     * Serve the PLC under the given unit id (1-247)
+     *
+     * The PLC must not be added to the network on its own.
+     */
+    void AddUnit(uint8_t uid, ns3::Ptr<PlcApplication> plc);
+
+    /// PLC served under the unit id, null if there's none
+    ns3::Ptr<PlcApplication> GetUnit(uint8_t uid) const;
+
+    uint16_t GetUnitCount() const;
+
+    /// Maximum amount of clients connected at the same time
+    void SetMaxConnections(uint16_t max);
+
+    /// Maximum amount of requests served per connection at once, see ModbusServer
+    void SetQueueDepth(uint16_t depth);
+
+    uint16_t GetConnectionCount() const;
+
+    /// Amount of requests answered with ServerDeviceBusy because a connection's queue was full
+    uint64_t GetBusyRequests() const;
+
+    /// Amount of requests for a unit id without a PLC
+    uint64_t GetUnroutedRequests() const;
+
+    /// Amount of requests dropped because their MBAP header was malformed
+    uint64_t GetMalformedRequests() const;
+
+    /// Send all the responses of the same instant to a client in a single packet (off by default)
+    void SetBatching(bool enable);
+
+    const ModbusBatcher &GetBatcher() const;
+
+protected:
+    void DoDispose() override;
+
+private:
+    void StartApplication() override;
+    void StopApplication() override;
+
+    /// Hand the request to the PLC of its unit id
+    void Dispatch(const ModbusADU &adu, std::vector<ModbusADU> &responses);
+
+    static constexpr uint16_t s_Port = 502;
+
+    ModbusServer m_Server;
+    std::array<ns3::Ptr<PlcApplication>, 256> m_Units; //!< PLC per unit id
+    uint16_t m_UnitCount = 0;
+    uint64_t m_UnroutedRequests = 0;
+};
@@ -1,6 +1,6 @@
 #include "plc-state.h"
 
-#include <limits>
+#include "bit-packing.h"
 
 void
 PlcState::SetDigitalState(uint8_t pos, bool value)
@@ -14,35 +14,87 @@ PlcState::GetDigitalState(uint8_t pos) const
     return GetBitBE(m_DigitalPorts, pos);
 }
 
-uint8_t
-PlcState::GetBits(uint16_t start, uint16_t num) const
+void
+PlcState::ReadBits(uint16_t start, uint16_t num, uint8_t *bits) const
+{
+    CopyBits(&m_DigitalPorts, start, bits, 0, num);
+}
+
+void
+PlcState::WriteBits(uint16_t start, uint16_t num, const uint8_t *bits)
 {
-    return GetBitsInRangeBE(start, num, m_DigitalPorts);
+    CopyBits(bits, 0, &m_DigitalPorts, start, num);
 }
 
 void
 PlcState::SetAnalogState(uint8_t pos, double value)
 {
-    if (pos > 2)
+    if (pos >= PLC_ANALOG_PORTS)
+        NS_FATAL_ERROR("Index out of bounds '" << (int)pos << "' for analog input");
+
+    // Convert the 4-20mA into a digital number
+    m_AnalogPorts[pos] = m_ADC.ToCounts(value, &m_AnalogRanges[pos]);
+}
+
+void
+PlcState::SetAnalogState(uint8_t pos, AnalogSensor& value)
+{
+    value.Sample();
+    SetAnalogState(pos, value.GetLoopCurrent());
+}
+
+void
+PlcState::SetAnalogStates(uint8_t start, const double *values, uint8_t num)
+{
+    if (start >= PLC_ANALOG_PORTS || num > PLC_ANALOG_PORTS - start)
+        NS_FATAL_ERROR("Index out of bounds '" << (int)start << "' for analog inputs");
+
+    m_ADC.ToCounts(values, m_AnalogPorts + start, num, m_AnalogRanges + start);
+}
+
+AnalogRange
+PlcState::GetAnalogRange(uint8_t pos) const
+{
+    if (pos >= PLC_ANALOG_PORTS)
         NS_FATAL_ERROR("Index out of bounds '" << (int)pos << "' for analog input");
 
-    // Convert the 4-20mA into a 16-bit digital number
-    m_AnalogPorts[pos] = static_cast<uint16_t>(NormalizeInRange(value, 4, 20) *
-                                               std::numeric_limits<uint16_t>::max());
+    return m_AnalogRanges[pos];
 }
 
 void
-PlcState::SetAnalogState(uint8_t pos, const AnalogSensor& value)
+PlcState::SetAnalogResolution(uint8_t bits)
+{
+    m_ADC.SetResolution(bits);
+}
+
+uint16_t
+PlcState::GetAnalogFullScale() const
 {
-    SetAnalogState(pos, value.GetOutputValue());
+    return m_ADC.GetFullScale();
 }
 
 uint16_t
 PlcState::GetAnalogState(uint8_t pos) const
 {
-    if (pos > 2)
+    if (pos >= PLC_ANALOG_PORTS)
         NS_FATAL_ERROR("Index out of bounds '" << (int)pos << "' for analog input");
 
     return m_AnalogPorts[pos];
 }
 
+
+void
+PlcState::Serialize(SnapshotWriter &writer) const
+{
+    writer.Write(m_DigitalPorts);
+    writer.Write(m_AnalogPorts);
+}
+
+void
+PlcState::Deserialize(SnapshotReader &reader)
+{
+    m_DigitalPorts = reader.Read<uint8_t>();
+
+    for (uint16_t &port : m_AnalogPorts)
+        port = reader.Read<uint16_t>();
+}
@@ -1,10 +1,16 @@
 #pragma once
 
+#include "analog-converter.h"
 #include "sensor.h"
+#include "snapshot.h"
 #include "utils.h"
 
 #include "ns3/fatal-error.h"
 
+// Size of the PLC images
+#define PLC_DIGITAL_PORTS 8
+#define PLC_ANALOG_PORTS 2
+
 class PlcState
 {
   public:
@@ -12,28 +18,67 @@ class PlcState
 
     bool GetDigitalState(uint8_t pos) const;
 
-    uint8_t GetBits(uint16_t start, uint16_t num) const;
+    /*
+     * Copy `num` digital ports starting at `start` into a packed bit buffer
+     * (LSB first, as in Modbus coil payloads)
+     */
+    void ReadBits(uint16_t start, uint16_t num, uint8_t *bits) const;
+
+    /*
+     * Set `num` digital ports starting at `start` from a packed bit buffer
+     */
+    void WriteBits(uint16_t start, uint16_t num, const uint8_t *bits);
 
     /*
      * Store the value of the input variable into a 16 bit register
      *
      * This simulates the internal ADC of the PLC converting a current
-     * in the range 4-20mA to a digital 16-bit value.
+     * in the range 4-20mA to a digital value. Currents out of the range
+     * saturate and are flagged (see GetAnalogRange).
      */
     void SetAnalogState(uint8_t pos, double value);
 
     /*
-     * Set the analog value but from a sensor directly
+     * Set the analog value but from a sensor directly, taking a new sample
+     * of it (see AnalogSensor::Sample)
+     */
+    void SetAnalogState(uint8_t pos, AnalogSensor& value);
+
+    /*
+     * Convert `num` currents (4-20mA) at once, starting at port `start`
+     */
+    void SetAnalogStates(uint8_t start, const double *values, uint8_t num);
+
+    /*
+     * Whether the last value stored in the port was out of the 4-20mA range
+     */
+    AnalogRange GetAnalogRange(uint8_t pos) const;
+
+    /*
+     * Set the resolution of the ADC in bits (16 by default), the registers
+     * hold values in the range [0, 2^bits - 1]
      */
-    void SetAnalogState(uint8_t pos, const AnalogSensor& value);
+    void SetAnalogResolution(uint8_t bits);
+
+    /*
+     * Largest value the ADC stores in the registers, pass it to
+     * DenormalizeU16InRange when reading them with a reduced resolution
+     */
+    uint16_t GetAnalogFullScale() const;
 
     /*
      * Retrieve the value stored in the PLC
      */
     uint16_t GetAnalogState(uint8_t pos) const;
 
+    void Serialize(SnapshotWriter &writer) const;
+
+    void Deserialize(SnapshotReader &reader);
+
   private:
     uint8_t m_DigitalPorts;
-    uint16_t m_AnalogPorts[2];
+    uint16_t m_AnalogPorts[PLC_ANALOG_PORTS];
+    AnalogRange m_AnalogRanges[PLC_ANALOG_PORTS] = {};
+    AnalogConverter m_ADC{4, 20};
 };
 
@@ -0,0 +1,168 @@
+#include "poll-scheduler.h"
+
+#include "ns3/fatal-error.h"
+#include "ns3/simulator.h"
+
+PollScheduler::~PollScheduler()
+{
+    Stop();
+}
+
+void
+PollScheduler::SetPollCallback(ns3::Callback<void, size_t> poll)
+{
+    m_Poll = poll;
+}
+
+void
+PollScheduler::SetMaxConcurrent(uint16_t max)
+{
+    m_MaxConcurrent = max;
+}
+
+size_t
+PollScheduler::AddRTU()
+{
+    m_Schedules.push_back(Schedule());
+    return m_Schedules.size() - 1;
+}
+
+void
+PollScheduler::SetSchedule(size_t rtu, ns3::Time rate, ns3::Time phase, PollPriority priority)
+{
+    Schedule &schedule = m_Schedules[rtu];
+
+    schedule.rate = rate;
+    schedule.autoPhase = phase.IsStrictlyNegative();
+    schedule.phase = phase;
+    schedule.priority = priority;
+}
+
+void
+PollScheduler::Start(ns3::Time defaultRate)
+{
+    Stop();
+
+    ns3::Time now = ns3::Simulator::Now();
+    size_t count = m_Schedules.size();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Schedule &schedule = m_Schedules[i];
+
+        ns3::Time rate = schedule.rate.IsZero() ? defaultRate : schedule.rate;
+        if (!rate.IsStrictlyPositive())
+            NS_FATAL_ERROR("Poll rate of RTU " << i << " should be greater than zero");
+
+        schedule.period = rate;
+
+        // Spread the RTUs evenly across their poll period
+        if (schedule.autoPhase)
+            schedule.phase = ns3::NanoSeconds(rate.GetNanoSeconds() * i / count);
+
+        m_Queue.push(Due{now + schedule.phase, schedule.priority, i});
+    }
+
+    if (!m_Queue.empty())
+        m_Event = ns3::Simulator::Schedule(m_Queue.top().time - now, &PollScheduler::Run, this);
+}
+
+void
+PollScheduler::Stop()
+{
+    m_Event.Cancel();
+
+    m_Queue = decltype(m_Queue)();
+
+    for (auto &deferred : m_Deferred)
+        deferred.clear();
+
+    for (Schedule &schedule : m_Schedules)
+        schedule.polling = schedule.deferred = false;
+
+    m_Active = 0;
+}
+
+void
+PollScheduler::Run()
+{
+    ns3::Time now = ns3::Simulator::Now();
+
+    // Due polls come out ordered by time and then by priority
+    while (!m_Queue.empty() && m_Queue.top().time <= now)
+    {
+        Due due = m_Queue.top();
+        m_Queue.pop();
+
+        Schedule &schedule = m_Schedules[due.rtu];
+        m_Queue.push(Due{due.time + schedule.period, schedule.priority, due.rtu});
+
+        if (schedule.polling || schedule.deferred)
+        {
+            m_SkippedCount++;
+            continue;
+        }
+
+        TryPoll(due.rtu);
+    }
+
+    if (!m_Queue.empty())
+        m_Event = ns3::Simulator::Schedule(m_Queue.top().time - now, &PollScheduler::Run, this);
+}
+
+void
+PollScheduler::TryPoll(size_t rtu)
+{
+    Schedule &schedule = m_Schedules[rtu];
+
+    if (m_MaxConcurrent > 0 && m_Active >= m_MaxConcurrent)
+    {
+        schedule.deferred = true;
+        m_Deferred[static_cast<size_t>(schedule.priority)].push_back(rtu);
+        m_DeferredCount++;
+        return;
+    }
+
+    schedule.polling = true;
+    m_Active++;
+
+    if (!m_Poll.IsNull())
+        m_Poll(rtu);
+}
+
+void
+PollScheduler::Complete(size_t rtu)
+{
+    Schedule &schedule = m_Schedules[rtu];
+
+    if (!schedule.polling)
+        return;
+
+    schedule.polling = false;
+    m_Active--;
+
+    // Hand the freed budget to the deferred polls, highest priority first
+    for (auto &deferred : m_Deferred)
+    {
+        while (!deferred.empty() && (m_MaxConcurrent == 0 || m_Active < m_MaxConcurrent))
+        {
+            size_t next = deferred.front();
+            deferred.pop_front();
+
+            m_Schedules[next].deferred = false;
+            TryPoll(next);
+        }
+    }
+}
+
+uint64_t
+PollScheduler::GetDeferred() const
+{
+    return m_DeferredCount;
+}
+
+uint64_t
+PollScheduler::GetSkipped() const
+{
+    return m_SkippedCount;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <queue>
+#include <vector>
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+
+/**
+ * Priority class of an RTU's polls, when several polls are due at the
+ * same time or are competing for the concurrency budget, higher priority
+ * polls go first.
+ */
+enum class PollPriority
+{
+    High = 0,
+    Normal = 1,
+    Low = 2,
+};
+
+/**
+ * Spreads the polls of many RTUs across time.
+ *
+ * Every RTU is polled at its own rate, starting at its own phase offset.
+ * By default the offsets spread the RTUs evenly across their poll period,
+ * so the requests don't collide on the channel in synchronized bursts.
+ *
+ * The scheduler keeps a single pending simulator event for the next due
+ * poll, no matter how many RTUs it handles. Optionally the amount of RTUs
+ * being polled at the same time is capped, polls that don't fit are
+ * deferred until another poll completes, highest priority first.
+ */
+class PollScheduler
+{
+public:
+    ~PollScheduler();
+
+    /// Called with the index of the RTU to poll
+    void SetPollCallback(ns3::Callback<void, size_t> poll);
+
+    /// Maximum amount of RTUs being polled at once (0 means no limit)
+    void SetMaxConcurrent(uint16_t max);
+
+    /// Register a new RTU with the default schedule, returns its index
+    size_t AddRTU();
+
+    /**
+     * Set the schedule of the RTU
+     *
+     * \param rate time between polls, zero uses the default rate
+     * \param phase offset of the first poll, negative spreads RTUs evenly
+     * \param priority priority class of the polls
+     */
+    void SetSchedule(size_t rtu, ns3::Time rate, ns3::Time phase, PollPriority priority);
+
+    /// Start polling, RTUs without their own rate are polled every `defaultRate`
+    void Start(ns3::Time defaultRate);
+
+    void Stop();
+
+    /// The poll of the RTU finished (all its responses arrived or were dropped)
+    void Complete(size_t rtu);
+
+    /// Polls that had to wait for the concurrency budget
+    uint64_t GetDeferred() const;
+
+    /// Polls skipped because the previous poll of the RTU was still running
+    uint64_t GetSkipped() const;
+
+private:
+    struct Schedule
+    {
+        ns3::Time rate;                 //!< Configured rate, zero uses the default rate
+        ns3::Time period;               //!< Rate in use since the last Start
+        ns3::Time phase;                //!< Offset of the first poll
+        bool autoPhase = true;          //!< Spread evenly instead of using the phase
+        PollPriority priority = PollPriority::Normal;
+        bool polling = false;           //!< Waiting for the responses of a poll
+        bool deferred = false;          //!< Waiting for the concurrency budget
+    };
+
+    /// A poll due at a given time, ordered by time and then by priority
+    struct Due
+    {
+        ns3::Time time;
+        PollPriority priority;
+        size_t rtu;
+
+        bool operator>(const Due &other) const
+        {
+            if (time != other.time)
+                return time > other.time;
+
+            return priority > other.priority;
+        }
+    };
+
+    /// Run the polls that are due and schedule the event for the next one
+    void Run();
+
+    /// Poll the RTU now if the budget allows, otherwise defer it
+    void TryPoll(size_t rtu);
+
+    uint16_t m_MaxConcurrent = 0;
+    uint16_t m_Active = 0; //!< RTUs being polled
+    std::vector<Schedule> m_Schedules;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> m_Queue;
+    std::array<std::deque<size_t>, 3> m_Deferred; //!< Deferred RTUs per priority class
+    ns3::Callback<void, size_t> m_Poll;
+    ns3::EventId m_Event;
+    uint64_t m_DeferredCount = 0;
+    uint64_t m_SkippedCount = 0;
+};
@@ -0,0 +1,193 @@
+#include "profiler.h"
+
+#include "ns3/simulator.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+bool Profiler::s_Enabled = false;
+std::string Profiler::s_Path;
+uint64_t Profiler::s_StartTicks = 0;
+uint64_t Profiler::s_StartTime = 0;
+std::vector<Profiler::Frame> Profiler::s_Stack;
+std::unordered_map<std::string, uint64_t> Profiler::s_Collapsed;
+std::map<std::string, Profiler::Stats> Profiler::s_Components;
+std::map<std::string, Profiler::Stats> Profiler::s_Nodes;
+std::map<std::string, Profiler::Stats> Profiler::s_PythonClasses;
+
+namespace
+{
+
+uint64_t
+GetNanoSeconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+void
+Profiler::Enable(const std::string &path)
+{
+#ifdef TINYICS_PROFILING
+    if (s_Enabled)
+        return;
+
+    s_Enabled = true;
+    s_Path = path;
+    s_StartTicks = ReadTicks();
+    s_StartTime = GetNanoSeconds();
+
+    ns3::Simulator::ScheduleDestroy(&Profiler::Dump);
+#else
+    std::clog << "TinyICS was built without TINYICS_PROFILING, the profiler is not available\n";
+#endif
+}
+
+bool
+Profiler::IsEnabled()
+{
+    return s_Enabled;
+}
+
+void
+Profiler::Enter(const char *component, std::string node)
+{
+    s_Stack.push_back({component, std::move(node), ReadTicks()});
+}
+
+void
+Profiler::Exit()
+{
+    // Enabled while inside of a scope, there's nothing to close
+    if (s_Stack.empty())
+        return;
+
+    Frame frame = std::move(s_Stack.back());
+    s_Stack.pop_back();
+
+    uint64_t total = ReadTicks() - frame.start;
+    uint64_t self = total > frame.children ? total - frame.children : 0;
+
+    if (!s_Stack.empty())
+        s_Stack.back().children += total;
+
+    // Collapsed stack, root first: "component:node;component:node"
+    std::string path;
+    for (const Frame &parent : s_Stack)
+    {
+        path += parent.component;
+        if (!parent.node.empty())
+            path += ':' + parent.node;
+        path += ';';
+    }
+
+    path += frame.component;
+    if (!frame.node.empty())
+        path += ':' + frame.node;
+
+    s_Collapsed[path] += self;
+
+    auto record = [total, self](Stats &stats) {
+        stats.calls++;
+        stats.total += total;
+        stats.self += self;
+    };
+
+    record(s_Components[frame.component]);
+
+    if (frame.node.empty())
+        return;
+
+    if (std::string(frame.component) == "python")
+        record(s_PythonClasses[frame.node]);
+    else
+        record(s_Nodes[frame.node]);
+}
+
+void
+Profiler::Dump()
+{
+    if (!s_Enabled)
+        return;
+
+    s_Enabled = false;
+
+    uint64_t ticks = ReadTicks() - s_StartTicks;
+    uint64_t time = GetNanoSeconds() - s_StartTime;
+    double nsPerTick = ticks ? double(time) / ticks : 1;
+
+    uint64_t profiled = 0;
+    for (const auto &[path, self] : s_Collapsed)
+        profiled += self;
+
+    std::ofstream out(s_Path);
+    if (!out)
+    {
+        std::clog << "Failed to write the profile to '" << s_Path << "'\n";
+    }
+    else
+    {
+        for (const auto &[path, self] : s_Collapsed)
+            out << path << ' ' << static_cast<uint64_t>(self * nsPerTick) << '\n';
+
+        // Everything outside of the tinyics scopes
+        if (ticks > profiled)
+            out << "ns-3 " << static_cast<uint64_t>((ticks - profiled) * nsPerTick) << '\n';
+    }
+
+    std::clog << "Profiled " << time / 1e9 << "s of wall time, "
+              << std::setprecision(3) << 100.0 * profiled / std::max<uint64_t>(ticks, 1)
+              << "% in tinyics scopes (collapsed stacks in " << s_Path << ")\n";
+
+    PrintTable("Component", s_Components, nsPerTick);
+    PrintTable("Node", s_Nodes, nsPerTick);
+    PrintTable("Python class", s_PythonClasses, nsPerTick);
+
+    s_Stack.clear();
+    s_Collapsed.clear();
+    s_Components.clear();
+    s_Nodes.clear();
+    s_PythonClasses.clear();
+}
+
+void
+Profiler::PrintTable(const char *title,
+                     const std::map<std::string, Stats> &stats,
+                     double nsPerTick)
+{
+    if (stats.empty())
+        return;
+
+    std::clog << '\n'
+              << std::left << std::setw(24) << title << std::right << std::setw(12) << "calls"
+              << std::setw(14) << "total ms" << std::setw(14) << "self ms" << std::setw(12)
+              << "us/call" << '\n';
+
+    for (const auto &[name, entry] : stats)
+    {
+        std::clog << std::left << std::setw(24) << name << std::right << std::setw(12)
+                  << entry.calls << std::fixed << std::setprecision(2) << std::setw(14)
+                  << entry.total * nsPerTick / 1e6 << std::setw(14) << entry.self * nsPerTick / 1e6
+                  << std::setw(12) << entry.total * nsPerTick / 1e3 / entry.calls << '\n'
+                  << std::defaultfloat;
+    }
+}
+
+uint64_t
+Profiler::ReadTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return GetNanoSeconds();
+#endif
+}
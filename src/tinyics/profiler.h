@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Attributes the wall time of a simulation to tinyics components.
+ *
+ * Scopes are placed around the callbacks tinyics runs from the simulator
+ * (plant updates, PLC and SCADA socket reads, flushes, Python overrides).
+ * Each scope records the time spent inside of it, minus the time of the
+ * scopes nested in it, under the stack of scopes it ran in. Time outside
+ * of every scope is the ns-3 stack and scheduler.
+ *
+ * At Simulator::Destroy the profiler writes the stacks in the collapsed
+ * format of flame graph tools ("plant;process;python:Tank 1234", in
+ * nanoseconds) and prints a summary per component, per node and per
+ * Python class.
+ *
+ * Only built when TINYICS_PROFILING is defined (CMake option of the same
+ * name), otherwise the scopes compile to nothing. Even when built it does
+ * nothing until enabled.
+ */
+class Profiler
+{
+public:
+    /// Start profiling, the collapsed stacks are written to `path` on destroy
+    static void Enable(const std::string &path);
+
+    static bool IsEnabled();
+
+    /// Write the collapsed stacks and print the summary (done at Simulator::Destroy)
+    static void Dump();
+
+    static void Enter(const char *component, std::string node);
+
+    static void Exit();
+
+private:
+    struct Frame
+    {
+        const char *component;
+        std::string node;
+        uint64_t start;
+        uint64_t children = 0; //!< Ticks spent in nested scopes
+    };
+
+    struct Stats
+    {
+        uint64_t calls = 0;
+        uint64_t total = 0; //!< Ticks, including nested scopes
+        uint64_t self = 0;  //!< Ticks, excluding nested scopes
+    };
+
+    /// Current value of the cycle counter (or of a nanosecond clock)
+    static uint64_t ReadTicks();
+
+    static void PrintTable(const char *title,
+                           const std::map<std::string, Stats> &stats,
+                           double nsPerTick);
+
+    static bool s_Enabled;
+    static std::string s_Path;
+    static uint64_t s_StartTicks;
+    static uint64_t s_StartTime; //!< Nanoseconds, to calibrate the ticks
+    static std::vector<Frame> s_Stack;
+    static std::unordered_map<std::string, uint64_t> s_Collapsed; //!< Self ticks per stack
+    static std::map<std::string, Stats> s_Components;
+    static std::map<std::string, Stats> s_Nodes;
+    static std::map<std::string, Stats> s_PythonClasses;
+};
+
+/**
+ * Profiles the enclosing scope, the node name is only computed when the
+ * profiler is enabled
+ */
+class ProfileScope
+{
+public:
+    template <typename F>
+    ProfileScope(const char *component, F node)
+        : m_Active(Profiler::IsEnabled())
+    {
+        if (m_Active)
+            Profiler::Enter(component, node());
+    }
+
+    ~ProfileScope()
+    {
+        if (m_Active)
+            Profiler::Exit();
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    bool m_Active;
+};
+
+#define TINYICS_PROFILE_CONCAT_(a, b) a##b
+#define TINYICS_PROFILE_CONCAT(a, b) TINYICS_PROFILE_CONCAT_(a, b)
+
+#ifdef TINYICS_PROFILING
+#define TINYICS_PROFILE_SCOPE(component, node)                                                     \
+    ProfileScope TINYICS_PROFILE_CONCAT(profileScope, __LINE__)(                                   \
+        component, [&]() -> std::string { return node; })
+#else
+#define TINYICS_PROFILE_SCOPE(component, node) ((void)0)
+#endif
@@ -1,5 +1,8 @@
 #include "scada-application.h"
 
+#include "industrial-plant.h"
+#include "profiler.h"
+
 ns3::TypeId
 ScadaApplication::GetTypeId()
 {
@@ -10,9 +13,14 @@ ScadaApplication::GetTypeId()
 }
 
 ScadaApplication::ScadaApplication(const char *name, double rate)
-    : IndustrialApplication(name)
+    : IndustrialApplication(name),
+      m_Transactions(m_Tracer, m_Batcher)
 {
     SetRefreshRate(rate);
+    m_Transactions.SetDropCallback(MakeCallback(&ScadaApplication::HandleDrop, this));
+    m_Poller.SetPollCallback(MakeCallback(&ScadaApplication::PollRTU, this));
+
+    IndustrialPlant::RegisterScada(this);
 }
 
 void
@@ -21,6 +29,170 @@ ScadaApplication::SetRefreshRate(uint64_t rate)
     m_Interval = ns3::MilliSeconds(rate);
 }
 
+void
+ScadaApplication::EnableTracing(bool enable)
+{
+    m_Tracer.Enable(enable);
+}
+
+const TransactionTracer &
+ScadaApplication::GetTracer() const
+{
+    return m_Tracer;
+}
+
+void
+ScadaApplication::SetTimeout(uint64_t timeout)
+{
+    m_Transactions.SetTimeout(ns3::MilliSeconds(timeout));
+}
+
+void
+ScadaApplication::SetRetries(uint8_t retries)
+{
+    m_Transactions.SetRetries(retries);
+}
+
+void
+ScadaApplication::SetBusyDelay(uint64_t delay)
+{
+    m_Transactions.SetBusyDelay(ns3::MilliSeconds(delay));
+}
+
+void
+ScadaApplication::SetMaxOutstanding(uint16_t window)
+{
+    m_Transactions.SetWindow(window);
+}
+
+uint64_t
+ScadaApplication::GetSkippedCycles() const
+{
+    return m_SkippedCycles;
+}
+
+uint64_t
+ScadaApplication::GetExceptionCount() const
+{
+    return m_Exceptions;
+}
+
+void
+ScadaApplication::SetBatching(bool enable)
+{
+    m_Batcher.SetEnabled(enable);
+}
+
+const ModbusBatcher &
+ScadaApplication::GetBatcher() const
+{
+    return m_Batcher;
+}
+
+void
+ScadaApplication::SetStaggeredPolling(bool enable)
+{
+    m_Staggered = enable;
+}
+
+void
+ScadaApplication::SetPollSchedule(size_t rtu,
+                                  uint64_t rate,
+                                  int64_t phase,
+                                  PollPriority priority)
+{
+    if (rtu >= m_RTUs.size())
+        NS_FATAL_ERROR("No RTU with handle " << rtu << " in SCADA '" << GetName() << '\'');
+
+    m_Poller.SetSchedule(rtu,
+                         ns3::MilliSeconds(rate),
+                         ns3::MilliSeconds(phase),
+                         priority);
+}
+
+void
+ScadaApplication::SetMaxConcurrentPolls(uint16_t max)
+{
+    m_Poller.SetMaxConcurrent(max);
+}
+
+uint64_t
+ScadaApplication::GetDeferredPolls() const
+{
+    return m_Poller.GetDeferred();
+}
+
+uint64_t
+ScadaApplication::GetSkippedPolls() const
+{
+    return m_Poller.GetSkipped();
+}
+
+void
+ScadaApplication::Serialize(SnapshotWriter &writer) const
+{
+    // Each connection has its own sequence of transaction ids
+    writer.Write<uint32_t>(m_RTUs.size());
+    for (size_t i = 0; i < m_RTUs.size(); i++)
+    {
+        bool started = i < m_Transactions.GetRTUCount();
+        writer.Write(started ? m_Transactions.GetNextTransactionId(i) : m_RTUs[i].nextTid);
+    }
+
+    writer.Write<uint32_t>(m_Vars.size());
+
+    for (const auto &[name, var] : m_Vars)
+    {
+        writer.WriteString(name);
+        writer.Write(var.GetValue());
+    }
+}
+
+void
+ScadaApplication::Deserialize(SnapshotReader &reader)
+{
+    auto rtus = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < rtus; i++)
+    {
+        auto tid = reader.Read<uint16_t>();
+
+        if (i < m_RTUs.size())
+            m_RTUs[i].nextTid = tid;
+    }
+
+    auto count = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        std::string name = reader.ReadString();
+        auto value = reader.Read<uint16_t>();
+
+        // Restored values are reported as changes on the first update
+        auto it = m_Vars.find(name);
+        if (it != m_Vars.end())
+            it->second.SetValue(value);
+    }
+}
+
+void
+ScadaApplication::SetReportByException(bool enable)
+{
+    m_ReportByException = enable;
+}
+
+void
+ScadaApplication::SetDeadband(const std::string &name, uint16_t deadband)
+{
+    auto it = m_Vars.find(name);
+
+    if (it == m_Vars.end())
+    {
+        std::clog << "Variable " << name << " is not defined, ignoring deadband\n";
+        return;
+    }
+
+    it->second.SetDeadband(deadband);
+}
+
 ScadaApplication::~ScadaApplication()
 {
     FreeSockets();
@@ -29,17 +201,81 @@ ScadaApplication::~ScadaApplication()
 void
 ScadaApplication::FreeSockets()
 {
-    for (auto socket : m_Sockets)
+    for (RTU &rtu : m_RTUs)
+    {
+        rtu.socket = nullptr;
+    }
+
+    m_RTUBySocket.clear();
+}
+
+size_t
+ScadaApplication::AddRTU(ns3::Ipv4Address addr, uint8_t uid)
+{
+    auto [it, inserted] = m_RTUByAddress.emplace(MakeKey(addr, uid), m_RTUs.size());
+
+    if (!inserted)
     {
-        socket = nullptr;
+        std::clog << "RTU " << addr << " (unit " << (int)uid << ") already added to SCADA '"
+                  << GetName() << "', ignoring\n";
+        return it->second;
     }
+
+    m_RTUs.emplace_back(addr, uid);
+    m_Poller.AddRTU();
+
+    return it->second;
+}
+
+size_t
+ScadaApplication::GetRTU(ns3::Ipv4Address addr, uint8_t uid) const
+{
+    auto it = m_RTUByAddress.find(MakeKey(addr, uid));
+    if (it == m_RTUByAddress.end())
+        NS_FATAL_ERROR("No RTU with address: '" << addr << "' (unit " << (int)uid
+                                                << ") in SCADA '" << GetName() << '\'');
+
+    return it->second;
+}
+
+size_t
+ScadaApplication::GetRTUCount() const
+{
+    return m_RTUs.size();
 }
 
 void
-ScadaApplication::AddRTU(ns3::Ipv4Address addr)
+ScadaApplication::SetChangeCallback(VarsCallback callback)
+{
+    m_ChangeCallback = callback;
+}
+
+ScadaApplication::VarsCallback
+ScadaApplication::GetChangeCallback() const
 {
-    m_PeerAddresses.push_back(addr);
-    m_ReadCommands.push_back(std::map<MB_FunctionCode, ReadCommand>());
+    return m_ChangeCallback;
+}
+
+ns3::Ipv4Address
+ScadaApplication::GetRTUAddress(size_t rtu) const
+{
+    return m_RTUs[rtu].address;
+}
+
+uint8_t
+ScadaApplication::GetRTUUnitId(size_t rtu) const
+{
+    return m_RTUs[rtu].uid;
+}
+
+uint16_t
+ScadaApplication::GetPendingTransactions(size_t rtu) const
+{
+    // The transactions of an RTU are only tracked once connected
+    if (rtu >= m_Transactions.GetRTUCount())
+        return 0;
+
+    return m_Transactions.GetInFlight(rtu) + m_Transactions.GetQueued(rtu);
 }
 
 void
@@ -52,77 +288,139 @@ void
 ScadaApplication::StartApplication()
 {
     // Setup communication with each remote terminal unit
-    for (const ns3::Address &address : m_PeerAddresses)
+    for (size_t i = 0; i < m_RTUs.size(); i++)
     {
+        RTU &rtu = m_RTUs[i];
+
         // Create a socket
         auto tid = ns3::TypeId::LookupByName("ns3::TcpSocketFactory");
         auto socket = ns3::Socket::CreateSocket(GetNode(), tid);
 
-        if (ns3::Ipv4Address::IsMatchingType(address) == true)
+        if (socket->Bind() == -1)
         {
-            if (socket->Bind() == -1)
-            {
-                NS_FATAL_ERROR("Failed to bind socket");
-            }
-            socket->Connect(
-                ns3::InetSocketAddress(ns3::Ipv4Address::ConvertFrom(address), s_PeerPort));
-        }
-        else
-        {
-            NS_FATAL_ERROR("[ScadaApplication] Incompatible address type: " << address);
+            NS_FATAL_ERROR("Failed to bind socket");
         }
+        socket->Connect(ns3::InetSocketAddress(rtu.address, s_PeerPort));
 
         socket->SetRecvCallback(MakeCallback(&ScadaApplication::HandleRead, this));
         socket->SetAllowBroadcast(true);
 
-        m_Sockets.push_back(socket);
+        rtu.socket = socket;
+        rtu.input.Clear();
+        m_RTUBySocket[ns3::PeekPointer(socket)] = i;
+        m_Transactions.AddRTU(socket, rtu.uid);
+        m_Transactions.SetNextTransactionId(i, rtu.nextTid);
     }
 
+    if (m_Staggered)
+        m_Poller.Start(m_Interval);
+
     ScheduleRead();
 }
 
 void
 ScadaApplication::StopApplication()
 {
-    for (auto socket : m_Sockets)
+    m_Poller.Stop();
+
+    // Continue the sequences of transaction ids after a restart
+    for (size_t i = 0; i < m_Transactions.GetRTUCount(); i++)
+        m_RTUs[i].nextTid = m_Transactions.GetNextTransactionId(i);
+
+    m_Transactions.Clear();
+    m_Batcher.Clear();
+
+    for (RTU &rtu : m_RTUs)
     {
-        socket->Close();
-        socket = nullptr;
+        rtu.socket->Close();
+        rtu.socket = nullptr;
     }
+
+    m_RTUBySocket.clear();
 }
 
 void
 ScadaApplication::ScheduleRead()
 {
     m_Step += m_Interval;
-    ns3::Simulator::Schedule(m_Step - ns3::Simulator::Now(), &ScadaApplication::SendAll, this);
+
+    if (m_Staggered)
+        ns3::Simulator::Schedule(m_Step - ns3::Simulator::Now(), &ScadaApplication::Scan, this);
+    else
+        ns3::Simulator::Schedule(m_Step - ns3::Simulator::Now(), &ScadaApplication::SendAll, this);
 }
 
 void
 ScadaApplication::SendAll()
 {
-    std::vector<int> sock;
-    for (int i = 0; i < m_Sockets.size(); i++)
+    TINYICS_PROFILE_SCOPE("scada_poll", GetName());
+
+    // Don't pile up requests while the previous poll cycle is still in flight
+    if (m_PendingPackets > 0)
     {
-        auto socket = m_Sockets[i];
+        m_SkippedCycles++;
+        ScheduleRead();
+        return;
+    }
 
-        for (const auto &command : m_ReadCommands[i])
+    for (size_t i = 0; i < m_RTUs.size(); i++)
+    {
+        for (const auto &command : m_RTUs[i].reads)
         {
-            command.second.Execute(socket, m_TransactionId, i + 1);
-            m_TransactionId++;
             m_PendingPackets++;
+            m_RTUs[i].pending++;
+            m_Transactions.Submit(i, command.second);
         }
     }
 
     ScheduleRead();
 }
 
+void
+ScadaApplication::PollRTU(size_t rtu)
+{
+    TINYICS_PROFILE_SCOPE("scada_poll", GetName());
+
+    for (const auto &command : m_RTUs[rtu].reads)
+    {
+        m_RTUs[rtu].pending++;
+        m_Transactions.Submit(rtu, command.second);
+    }
+
+    // Nothing to read from this RTU
+    if (m_RTUs[rtu].pending == 0)
+        m_Poller.Complete(rtu);
+}
+
+void
+ScadaApplication::Scan()
+{
+    DoUpdate();
+    ScheduleRead();
+}
+
+void
+ScadaApplication::ReadDone(size_t rtu)
+{
+    if (--m_RTUs[rtu].pending == 0 && m_Staggered)
+        m_Poller.Complete(rtu);
+}
+
 /**
  * Here we should decode the incoming data to affect the ScadaApplication's state
  */
 void
 ScadaApplication::HandleRead(ns3::Ptr<ns3::Socket> socket)
 {
+    TINYICS_PROFILE_SCOPE("scada_read", GetName());
+
+    auto found = m_RTUBySocket.find(ns3::PeekPointer(socket));
+    if (found == m_RTUBySocket.end())
+        return;
+
+    size_t idx = found->second;
+    RTU &rtu = m_RTUs[idx];
+
     ns3::Ptr<ns3::Packet> packet;
     ns3::Address from;
 
@@ -133,32 +431,67 @@ ScadaApplication::HandleRead(ns3::Ptr<ns3::Socket> socket)
     {
         if (ns3::InetSocketAddress::IsMatchingType(from))
         {
-            for (const ModbusADU &adu : ModbusADU::GetModbusADUs(packet))
+            for (const ModbusADU &adu : rtu.input.Read(packet))
             {
-                if (adu.GetFunctionCode() != MB_FunctionCode::WriteSingleCoil)
+                // Malformed responses are left to time out
+                if (!adu.IsValidFrame())
+                    continue;
+
+                // The RTU couldn't serve the request yet, it is sent again later
+                if (ModbusResponseProcessor::GetException(adu) ==
+                        MB_ExceptionCode::ServerDeviceBusy &&
+                    m_Transactions.Defer(idx, adu.GetTransactionID()))
                 {
-                    doUpdate = true;
-                    m_PendingPackets--;
+                    continue;
                 }
 
-                auto idx = adu.GetUnitID() - 1;
+                // Ignore responses to requests that are no longer in flight
+                if (!m_Transactions.Complete(idx, adu.GetTransactionID()))
+                    continue;
 
-                auto type = Var::IntoVarType(adu.GetFunctionCode());
+                // Exceptions carry the function code of the request with the highest bit set
+                auto fc = static_cast<MB_FunctionCode>(adu.GetFunctionCode() & 0x7F);
+                auto read = rtu.reads.find(fc);
+                bool write = GetFunctionTraits(fc).write;
 
-                std::vector<Var *> vars;
+                MB_ExceptionCode exception = ModbusResponseProcessor::GetException(adu);
 
-                // Update variables of the same function code and in the same RTU
-                for (auto &var : m_Vars)
+                if (exception != MB_ExceptionCode::NoException)
                 {
-                    if (type == var.second.GetType() && var.second.GetUID() == adu.GetUnitID())
-                        vars.push_back(&var.second);
+                    // The request failed but it is answered, release its slot right away
+                    m_Tracer.OnException(idx, fc);
+                    m_Exceptions++;
                 }
+                else if (write || read != rtu.reads.end())
+                {
+                    auto type = Var::IntoVarType(fc);
 
-                uint16_t start;
-                if (adu.GetFunctionCode() != MB_FunctionCode::WriteSingleCoil)
-                    start = m_ReadCommands[idx].at(adu.GetFunctionCode()).GetStart();
+                    std::vector<Var *> vars;
 
-                ModbusResponseProcessor::Execute(adu.GetFunctionCode(), adu, vars, start);
+                    // Update variables of the same function code in this RTU
+                    for (Var *var : rtu.vars)
+                    {
+                        if (type == var->GetType())
+                            vars.push_back(var);
+                    }
+
+                    uint16_t start = 0;
+                    if (!write)
+                        start = read->second.GetStart();
+
+                    ModbusResponseProcessor::Execute(fc, adu, vars, start);
+                }
+
+                if (!write)
+                {
+                    ReadDone(idx);
+
+                    if (!m_Staggered)
+                    {
+                        doUpdate = true;
+                        m_PendingPackets--;
+                    }
+                }
             }
         }
     }
@@ -167,20 +500,59 @@ ScadaApplication::HandleRead(ns3::Ptr<ns3::Socket> socket)
         DoUpdate();
 }
 
+void
+ScadaApplication::HandleDrop(size_t rtu, MB_FunctionCode fc)
+{
+    // Only reads take part in the polling cycle
+    if (GetFunctionTraits(fc).write)
+        return;
+
+    ReadDone(rtu);
+
+    if (m_Staggered)
+        return;
+
+    // Run the update with the last known values instead of stalling the loop
+    m_PendingPackets--;
+
+    if (m_PendingPackets == 0)
+        DoUpdate();
+}
+
 void
 ScadaApplication::DoUpdate()
 {
-    Update(m_Vars);
+    TINYICS_PROFILE_SCOPE("scada_update", GetName());
 
-    // After executing the reads and updating variables we execute the writes
-    for (auto it = m_WriteCommands.begin(); it != m_WriteCommands.end();)
+    std::map<std::string, Var> changed;
+
+    for (auto &[name, var] : m_Vars)
+    {
+        if (var.IsDirty())
+        {
+            var.ClearDirty();
+            changed.insert(std::pair(name, var));
+        }
+    }
+
+    if (!changed.empty())
     {
-        auto socket = m_Sockets[it->GetUID() - 1];
+        OnChange(changed);
+
+        if (!m_ChangeCallback.IsNull())
+            m_ChangeCallback(GetName(), changed);
+    }
 
-        it->Execute(socket, m_TransactionId);
-        it = m_WriteCommands.erase(it);
+    if (!m_ReportByException || !changed.empty())
+        Update(m_Vars);
 
-        m_TransactionId++;
+    // After executing the reads and updating variables we execute the writes
+    for (size_t i = 0; i < m_RTUs.size(); i++)
+    {
+        for (const WriteCommand &command : m_RTUs[i].writes)
+            m_Transactions.Submit(i, command);
+
+        m_RTUs[i].writes.clear();
     }
 }
 
@@ -189,11 +561,18 @@ ScadaApplication::AddVariable(const ns3::Ptr<PlcApplication> &plc,
                               const std::string &name,
                               VarType type,
                               uint8_t pos)
+{
+    AddVariable(GetRTU(plc->GetAddress()), name, type, pos);
+}
+
+void
+ScadaApplication::AddVariable(size_t rtu, const std::string &name, VarType type, uint8_t pos)
 {
     // Map VarType to the corresponding modbus function code
     MB_FunctionCode fc = Var::IntoFCRead(type);
 
-    int idx = GetRTUIndex(plc->GetAddress());
+    if (rtu >= m_RTUs.size())
+        NS_FATAL_ERROR("No RTU with handle " << rtu << " in SCADA '" << GetName() << '\'');
 
     // If the variable is already registered then, ignore this one
     if (m_Vars.find(name) != m_Vars.end())
@@ -202,11 +581,12 @@ ScadaApplication::AddVariable(const ns3::Ptr<PlcApplication> &plc,
         return;
     }
 
-    m_Vars.insert(std::pair(name, Var(type, pos, idx + 1)));
+    auto it = m_Vars.insert(std::pair(name, Var(type, pos, rtu))).first;
+    m_RTUs[rtu].vars.push_back(&it->second);
 
     /* Build a command to send the appropriate request */
 
-    auto &commandMap = m_ReadCommands[idx];
+    auto &commandMap = m_RTUs[rtu].reads;
 
     // If there isn't a command for the Function Code add it
     if (commandMap.find(fc) == commandMap.end())
@@ -217,16 +597,6 @@ ScadaApplication::AddVariable(const ns3::Ptr<PlcApplication> &plc,
     commandMap.at(fc).SetReadCount(pos);
 }
 
-int
-ScadaApplication::GetRTUIndex(const ns3::Address &rtuAddr)
-{
-    auto it = std::find(m_PeerAddresses.begin(), m_PeerAddresses.end(), rtuAddr);
-    if (it == m_PeerAddresses.end())
-        NS_FATAL_ERROR("No RTU with address: '" << rtuAddr << "' in SCADA '" << GetName() << '\'');
-
-    return it - m_PeerAddresses.begin();
-}
-
 void
 ScadaApplication::Write(const std::map<std::string, uint16_t> &vars)
 {
@@ -241,10 +611,12 @@ ScadaApplication::Write(const std::map<std::string, uint16_t> &vars)
             // Only write if the value changed
             if (original.GetType() == VarType::Coil && original.GetValue() != var.second)
             {
-                m_WriteCommands.emplace_back(WriteCommand(MB_FunctionCode::WriteSingleCoil,
-                                                          original.GetPosition(),
-                                                          var.second,
-                                                          original.GetUID()));
+                RTU &rtu = m_RTUs[original.GetRTU()];
+
+                rtu.writes.emplace_back(WriteCommand(MB_FunctionCode::WriteSingleCoil,
+                                                     original.GetPosition(),
+                                                     var.second,
+                                                     rtu.uid));
             }
         }
     }
@@ -1,12 +1,18 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "ns3/application.h"
 #include "ns3/ipv4-address.h"
 
 #include "industrial-application.h"
+#include "modbus-batcher.h"
 #include "modbus-command.h"
 #include "modbus-response.h"
+#include "modbus-tracer.h"
+#include "modbus-transaction.h"
 #include "plc-application.h"
+#include "poll-scheduler.h"
 
 namespace ns3
 {
@@ -34,17 +40,36 @@ public:
     ~ScadaApplication() override;
 
     /**
-     * Set the remote address
+     * Register an RTU, the SCADA opens a connection to it when started
      *
      * \param addr remote address
+     * \param uid unit id sent on the connection
+     *
+     * \returns the handle of the RTU
      */
-    void AddRTU(ns3::Ipv4Address addr);
+    size_t AddRTU(ns3::Ipv4Address addr, uint8_t uid = 1);
+
+    /// Get the handle of a registered RTU. Crashes if not found
+    size_t GetRTU(ns3::Ipv4Address addr, uint8_t uid = 1) const;
+
+    size_t GetRTUCount() const;
 
+    ns3::Ipv4Address GetRTUAddress(size_t rtu) const;
+
+    uint8_t GetRTUUnitId(size_t rtu) const;
+
+    /// Amount of requests to the RTU in flight or waiting for a free slot in its window
+    uint16_t GetPendingTransactions(size_t rtu) const;
+
+    /// Read the variable from the RTU at the PLC's address (with the default unit id)
     void AddVariable(const ns3::Ptr<PlcApplication> &plc,
                      const std::string &name,
                      VarType type,
                      uint8_t pos);
 
+    /// Read the variable from the RTU with the given handle
+    void AddVariable(size_t rtu, const std::string &name, VarType type, uint8_t pos);
+
     /*
      * Run the update/logic of the SCADA
      *
@@ -55,10 +80,99 @@ public:
     {
     }
 
+    /*
+     * Called with only the variables that changed since the last update
+     *
+     * Is expected to be overwritten, does nothing by default. Analog variables
+     * are only reported once they move further than their deadband.
+     */
+    virtual void OnChange(const std::map<std::string, Var> &changed)
+    {
+    }
+
+    /// Skip the call to Update when no variable changed since the last update
+    void SetReportByException(bool enable);
+
+    /// Minimum change (in raw register units) needed to report the variable as changed
+    void SetDeadband(const std::string &name, uint16_t deadband);
+
     void Write(const std::map<std::string, uint16_t> &vars);
 
+    /// Signature of the callbacks notified with the name of the SCADA and a set of variables
+    using VarsCallback =
+        ns3::Callback<void, const std::string &, const std::map<std::string, Var> &>;
+
+    /// Notify the variables that changed on every update, after OnChange
+    void SetChangeCallback(VarsCallback callback);
+
+    VarsCallback GetChangeCallback() const;
+
     void SetRefreshRate(uint64_t rate);
 
+    /// Enable timing of every Modbus transaction sent by the SCADA
+    void EnableTracing(bool enable = true);
+
+    /// Get the latency histograms and counters per RTU and function code
+    const TransactionTracer &GetTracer() const;
+
+    /// Time in milliseconds to wait for a response before retrying a request
+    void SetTimeout(uint64_t timeout);
+
+    /// Amount of times a request is retried (after a timeout or a busy answer) before it is dropped
+    void SetRetries(uint8_t retries);
+
+    /// Time in milliseconds to wait before retrying a request the RTU was too busy to serve
+    void SetBusyDelay(uint64_t delay);
+
+    /// Maximum amount of requests in flight per RTU, the rest are queued
+    void SetMaxOutstanding(uint16_t window);
+
+    /// Amount of poll cycles skipped because the previous one was still in flight
+    uint64_t GetSkippedCycles() const;
+
+    /// Amount of exception responses received (e.g. a variable out of the RTU's range)
+    uint64_t GetExceptionCount() const;
+
+    /// Send all the requests of the same instant to an RTU in a single packet (off by default)
+    void SetBatching(bool enable);
+
+    const ModbusBatcher &GetBatcher() const;
+
+    /**
+     * Poll every RTU on its own staggered schedule instead of all at once.
+     *
+     * The logic (Update/OnChange) still runs every refresh period with the
+     * latest values received, independently of the polls.
+     */
+    void SetStaggeredPolling(bool enable);
+
+    /**
+     * Set the poll schedule of an RTU, used with staggered polling
+     *
+     * \param rtu handle returned by AddRTU (or GetRTU)
+     * \param rate time in milliseconds between polls, 0 uses the refresh rate
+     * \param phase offset in milliseconds of the first poll, negative spreads RTUs evenly
+     * \param priority priority of the polls when the concurrency budget is exhausted
+     */
+    void SetPollSchedule(size_t rtu,
+                         uint64_t rate,
+                         int64_t phase = -1,
+                         PollPriority priority = PollPriority::Normal);
+
+    /// Maximum amount of RTUs polled at the same time (0 means no limit)
+    void SetMaxConcurrentPolls(uint16_t max);
+
+    /// Polls that had to wait for another RTU's poll to complete
+    uint64_t GetDeferredPolls() const;
+
+    /// Polls skipped because the previous poll of the RTU was still in flight
+    uint64_t GetSkippedPolls() const;
+
+    /// Write the tag store and transaction ids into the snapshot
+    void Serialize(SnapshotWriter &writer) const;
+
+    void Deserialize(SnapshotReader &reader);
+
 protected:
     void DoDispose() override;
 
@@ -73,16 +187,15 @@ private:
      */
     void ScheduleRead();
 
-    /**
-     * Get index for the RTU in the Address vector. Crashes if not found
-     *
-     * \returns int index of the RTU
-     */
-    int GetRTUIndex(const ns3::Address &rtuAddr);
-
     /// Send a packet to all connected devices
     void SendAll();
 
+    /// Send the read requests of a single RTU (staggered polling)
+    void PollRTU(size_t rtu);
+
+    /// Run the logic with the latest values (staggered polling)
+    void Scan();
+
     void DoUpdate();
 
     /**
@@ -93,18 +206,56 @@ private:
      * \param socket the socket the packet was received to.
      */
     void HandleRead(ns3::Ptr<ns3::Socket> socket);
+
+    /// Release the slot of a request that ran out of retries
+    void HandleDrop(size_t rtu, MB_FunctionCode fc);
+
+    /// A read of the RTU was answered or dropped
+    void ReadDone(size_t rtu);
+
     void FreeSockets();
 
+    /// Connection to an RTU and everything the SCADA reads from and writes to it
+    struct RTU
+    {
+        RTU(ns3::Ipv4Address address, uint8_t uid)
+            : address(address),
+              uid(uid)
+        {
+        }
+
+        ns3::Ipv4Address address;
+        uint8_t uid;                                  //!< Unit id sent on the connection
+        ns3::Ptr<ns3::Socket> socket;
+        ModbusStream input;                           //!< Responses split across packets
+        std::map<MB_FunctionCode, ReadCommand> reads; //!< Read plan, one command per function code
+        std::list<WriteCommand> writes;               //!< Writes waiting for the next update
+        std::vector<Var *> vars;                      //!< Variables read from the RTU
+        uint16_t pending = 0;                         //!< Reads in flight
+        uint16_t nextTid = 0;                         //!< First transaction id, from a snapshot
+    };
+
+    static inline uint64_t MakeKey(ns3::Ipv4Address addr, uint8_t uid)
+    {
+        return (static_cast<uint64_t>(addr.Get()) << 8) | uid;
+    }
+
     ns3::Time m_Interval;                         //!< Packet inter-send time
     ns3::Time m_Step;                             //!< Packet inter-send time
-    std::vector<ns3::Ptr<ns3::Socket>> m_Sockets; //!< Socket per RTU
-    std::vector<ns3::Address> m_PeerAddresses;    //!< Address per RTU
-    uint16_t m_TransactionId;                     //!< TransactionId for the Modbus ADU
-    uint16_t m_PendingPackets = 0;
-    std::vector<std::map<MB_FunctionCode, ReadCommand>>
-        m_ReadCommands; //!< Commands to execute for each RTU
+    std::vector<RTU> m_RTUs;                      //!< RTUs by handle
+    std::unordered_map<uint64_t, size_t> m_RTUByAddress;     //!< (address, uid) -> handle
+    std::unordered_map<ns3::Socket *, size_t> m_RTUBySocket; //!< Connection -> handle
+    uint16_t m_PendingPackets = 0;                //!< Reads of the current poll cycle
+    uint64_t m_SkippedCycles = 0;                 //!< Polls skipped while a cycle was in flight
+    uint64_t m_Exceptions = 0;                    //!< Exception responses received
+    bool m_Staggered = false;                     //!< Poll each RTU on its own schedule
+    bool m_ReportByException = false;             //!< Only call Update on changes
     std::map<std::string, Var> m_Vars;
-    std::list<WriteCommand> m_WriteCommands;
+    TransactionTracer m_Tracer;           //!< Latency and outcome of each transaction
+    ModbusBatcher m_Batcher;              //!< Outbound buffer per RTU socket
+    TransactionManager m_Transactions;    //!< In-flight requests, deadlines and retries
+    PollScheduler m_Poller;               //!< Staggered poll schedule per RTU
+    VarsCallback m_ChangeCallback;        //!< Observer of the changed variables
 
     static constexpr uint16_t s_PeerPort = 502; //!< Remote peer port
 };
@@ -0,0 +1,440 @@
+#include "scenario.h"
+
+#include "continuous-process.h"
+#include "industrial-plant.h"
+#include "simulation-runner.h"
+
+namespace
+{
+
+/**
+ * Native process model of a scenario, the state variables listed as
+ * sensors are reported to the PLC analog inputs
+ */
+class ScenarioProcess : public ContinuousProcess
+{
+public:
+    struct Sensor
+    {
+        size_t state;
+        uint8_t port;
+        AnalogSensor sensor;
+    };
+
+    ScenarioProcess(size_t dimension, std::vector<Sensor> sensors)
+        : ContinuousProcess(dimension),
+          m_Sensors(std::move(sensors))
+    {
+    }
+
+    void Measure(const std::vector<double> &state, PlcState *measurements) override
+    {
+        for (Sensor &sensor : m_Sensors)
+        {
+            sensor.sensor = state[sensor.state];
+            measurements->SetAnalogState(sensor.port, sensor.sensor);
+        }
+    }
+
+private:
+    std::vector<Sensor> m_Sensors;
+};
+
+void
+TankKernel(double t, const double *x, double *dxdt, const PlcState *input, const double *p)
+{
+    double flow = 0;
+
+    if (input->GetDigitalState(static_cast<uint8_t>(p[3])))
+        flow += p[0];
+
+    if (input->GetDigitalState(static_cast<uint8_t>(p[4])) && x[0] > 0)
+        flow -= p[1];
+
+    dxdt[0] = flow / p[2];
+}
+
+void
+FirstOrderKernel(double t, const double *x, double *dxdt, const PlcState *input, const double *p)
+{
+    double setpoint = input->GetDigitalState(static_cast<uint8_t>(p[2])) ? p[0] : 0;
+
+    dxdt[0] = (setpoint - x[0]) / p[1];
+}
+
+void
+RegisterBuiltinKernels()
+{
+    static bool registered = false;
+
+    if (registered)
+        return;
+
+    ContinuousProcess::RegisterKernel("tank", &TankKernel, 5);
+    ContinuousProcess::RegisterKernel("first_order", &FirstOrderKernel, 3);
+
+    registered = true;
+}
+
+VarType
+ParseVarType(const std::string &type)
+{
+    if (type == "coil")
+        return VarType::Coil;
+
+    if (type == "digital_input")
+        return VarType::DigitalInput;
+
+    if (type == "input_register")
+        return VarType::InputRegister;
+
+    NS_FATAL_ERROR("Unknown tag type '" << type
+                                        << "' (expected coil, digital_input or input_register)");
+}
+
+Integrator
+ParseIntegrator(const std::string &integrator)
+{
+    if (integrator == "rk4")
+        return Integrator::RK4;
+
+    if (integrator == "dormand-prince")
+        return Integrator::DormandPrince;
+
+    NS_FATAL_ERROR("Unknown integrator '" << integrator << "' (expected rk4 or dormand-prince)");
+}
+
+std::vector<double>
+ParseNumbers(const JsonValue &array)
+{
+    std::vector<double> numbers;
+    numbers.reserve(array.AsArray().size());
+
+    for (const JsonValue &number : array.AsArray())
+        numbers.push_back(number.AsNumber());
+
+    return numbers;
+}
+
+} // namespace
+
+std::unique_ptr<Scenario>
+Scenario::Load(const std::string &path)
+{
+    return Load(JsonValue::ParseFile(path), path);
+}
+
+std::unique_ptr<Scenario>
+Scenario::Load(const JsonValue &document, const std::string &source)
+{
+    RegisterBuiltinKernels();
+
+    std::unique_ptr<Scenario> scenario(new Scenario());
+    scenario->m_Source = source;
+
+    const JsonValue &network = document["network"];
+    scenario->m_Builder = std::make_unique<IndustrialNetworkBuilder>(
+        ns3::Ipv4Address(network.GetString("address", "192.168.1.0").c_str()),
+        ns3::Ipv4Mask(network.GetString("mask", "255.255.255.0").c_str()));
+
+    // Large scenarios don't need the per node names and logs
+    scenario->m_Builder->SetNameRegistration(network.GetBool("register_names", true));
+    scenario->m_Builder->SetVerbose(network.GetBool("verbose", true));
+    scenario->m_Builder->SetLightweightStack(network.GetBool("lightweight_stack", false));
+
+    if (document.Has("refresh_rate"))
+        IndustrialPlant::SetRefreshRate(document["refresh_rate"].AsNumber());
+
+    scenario->m_Duration = document.GetNumber("duration", 10);
+
+    size_t devices = 0;
+    for (const char *kind : {"plcs", "hosts", "scadas"})
+        devices += document.Has(kind) ? document[kind].AsArray().size() : 0;
+
+    scenario->m_Plcs.reserve(devices);
+    scenario->m_Endpoints.reserve(devices);
+    scenario->m_Scadas.reserve(devices);
+    scenario->m_Builder->Reserve(devices);
+
+    if (document.Has("plcs"))
+    {
+        for (const JsonValue &plc : document["plcs"].AsArray())
+        {
+            ns3::Ptr<PlcApplication> app = scenario->CreatePlc(plc);
+
+            scenario->m_Builder->AddToNetwork(app);
+            scenario->m_Endpoints.push_back({app, 1});
+        }
+    }
+
+    if (document.Has("hosts"))
+    {
+        for (const JsonValue &host : document["hosts"].AsArray())
+            scenario->AddHost(host);
+    }
+
+    const JsonValue *scadas = document.Has("scadas") ? &document["scadas"] : nullptr;
+    if (scadas)
+    {
+        for (const JsonValue &scada : scadas->AsArray())
+            scenario->AddScada(scada);
+    }
+
+    scenario->m_Builder->BuildNetwork();
+
+    // The RTUs are referenced by address, which is only known after building
+    for (size_t i = 0; i < scenario->m_Scadas.size(); i++)
+        scenario->ConnectScada(*scenario->m_Scadas[i], scadas->AsArray()[i]);
+
+    if (network.Has("pcap"))
+        scenario->m_Builder->EnablePcap(network["pcap"].AsString());
+
+    scenario->SetupRunner(document);
+
+    // Live statistics for tinyics-stats
+    if (document.Has("stats"))
+    {
+        const JsonValue &stats = document["stats"];
+        StatsPublisher::Open(stats.GetString("name", "/tinyics"), stats.GetNumber("period", 100));
+
+        for (const ns3::Ptr<ScadaApplication> &scada : scenario->m_Scadas)
+            StatsPublisher::Watch(scada);
+    }
+
+    return scenario;
+}
+
+void
+Scenario::Run()
+{
+    SimulationRunner::Run(m_Duration);
+}
+
+double
+Scenario::GetDuration() const
+{
+    return m_Duration;
+}
+
+ns3::Ptr<PlcApplication>
+Scenario::GetPlc(const std::string &name) const
+{
+    return m_Plcs[GetPlcIndex(name)];
+}
+
+size_t
+Scenario::GetPlcIndex(const std::string &name) const
+{
+    auto plc = m_PlcByName.find(name);
+
+    if (plc == m_PlcByName.end())
+        NS_FATAL_ERROR("No PLC named '" << name << "' in the scenario");
+
+    return plc->second;
+}
+
+ns3::Ptr<ScadaApplication>
+Scenario::GetScada(const std::string &name) const
+{
+    for (const auto &scada : m_Scadas)
+    {
+        if (scada->GetName() == name)
+            return scada;
+    }
+
+    NS_FATAL_ERROR("No SCADA named '" << name << "' in the scenario");
+}
+
+const std::vector<ns3::Ptr<PlcApplication>> &
+Scenario::GetPlcs() const
+{
+    return m_Plcs;
+}
+
+const std::vector<ns3::Ptr<ScadaApplication>> &
+Scenario::GetScadas() const
+{
+    return m_Scadas;
+}
+
+const BuildProfile &
+Scenario::GetBuildProfile() const
+{
+    return m_Builder->GetProfile();
+}
+
+ns3::Ptr<PlcApplication>
+Scenario::CreatePlc(const JsonValue &config)
+{
+    auto plc = ns3::CreateObject<PlcApplication>(config["name"].AsString().c_str());
+
+    if (config.Has("process"))
+    {
+        const JsonValue &model = config["process"];
+        std::vector<double> state = ParseNumbers(model["state"]);
+
+        std::vector<ScenarioProcess::Sensor> sensors;
+        if (model.Has("sensors"))
+        {
+            for (const JsonValue &sensor : model["sensors"].AsArray())
+            {
+                auto index = static_cast<size_t>(sensor["state"].AsNumber());
+
+                if (index >= state.size())
+                    NS_FATAL_ERROR("Sensor of PLC " << plc->GetName() << " reads state " << index
+                                                    << " but the process has " << state.size());
+
+                sensors.push_back(
+                    {index,
+                     static_cast<uint8_t>(sensor["port"].AsNumber()),
+                     AnalogSensor(sensor["min"].AsNumber(), sensor["max"].AsNumber())});
+            }
+        }
+
+        // The kernel reads its parameters without checking how many there are
+        const std::string &kernel = model["kernel"].AsString();
+        std::vector<double> parameters;
+
+        if (model.Has("parameters"))
+            parameters = ParseNumbers(model["parameters"]);
+
+        size_t needed = ContinuousProcess::GetKernelParameters(kernel);
+        if (parameters.size() < needed)
+            NS_FATAL_ERROR(m_Source << ":" << model.GetLine() << ": kernel '" << kernel
+                                    << "' of PLC " << plc->GetName() << " needs " << needed
+                                    << " parameters but got " << parameters.size());
+
+        auto process = std::make_shared<ScenarioProcess>(state.size(), std::move(sensors));
+        process->SetState(state);
+        process->SetKernel(kernel);
+        process->SetParameters(parameters);
+        process->SetIntegrator(ParseIntegrator(model.GetString("integrator", "rk4")));
+
+        if (model.Has("max_step"))
+            process->SetMaxStep(model["max_step"].AsNumber());
+
+        // The relative tolerance is the same as the absolute one unless given
+        if (model.Has("tolerance"))
+        {
+            double tolerance = model["tolerance"].AsNumber();
+            process->SetTolerance(tolerance, model.GetNumber("relative_tolerance", tolerance));
+        }
+
+        plc->LinkProcess(process, model.GetNumber("priority", 0));
+    }
+
+    if (!m_PlcByName.emplace(plc->GetName(), m_Plcs.size()).second)
+        NS_FATAL_ERROR("Duplicated PLC name '" << plc->GetName() << "' in the scenario");
+
+    m_Plcs.push_back(plc);
+
+    return plc;
+}
+
+void
+Scenario::AddHost(const JsonValue &config)
+{
+    auto host = ns3::CreateObject<PlcHost>(config["name"].AsString().c_str());
+
+    for (const JsonValue &unit : config["units"].AsArray())
+    {
+        auto uid = static_cast<uint8_t>(unit["uid"].AsNumber());
+
+        host->AddUnit(uid, CreatePlc(unit));
+        m_Endpoints.push_back({host, uid});
+    }
+
+    m_Builder->AddToNetwork(host);
+}
+
+void
+Scenario::AddScada(const JsonValue &config)
+{
+    ns3::Ptr<ScadaApplication> scada;
+
+    // Historians poll like any SCADA, but record the tags instead of running logic
+    if (config.Has("historian"))
+    {
+        const JsonValue &options = config["historian"];
+        auto historian = ns3::CreateObject<Historian>(config["name"].AsString().c_str(),
+                                                      config.GetNumber("rate", 500));
+
+        historian->SetRecordOnChange(options.GetBool("on_change", false));
+        historian->SetRetention(options.GetNumber("retention", 0));
+        historian->SetMemoryLimit(options.GetNumber("memory_limit", 0));
+        scada = historian;
+    }
+    else
+    {
+        scada = ns3::CreateObject<ScadaApplication>(config["name"].AsString().c_str(),
+                                                    config.GetNumber("rate", 500));
+    }
+
+    if (config.Has("timeout"))
+        scada->SetTimeout(config["timeout"].AsNumber());
+
+    if (config.Has("retries"))
+        scada->SetRetries(config["retries"].AsNumber());
+
+    if (config.Has("max_outstanding"))
+        scada->SetMaxOutstanding(config["max_outstanding"].AsNumber());
+
+    scada->SetBatching(config.GetBool("batching", false));
+    scada->SetReportByException(config.GetBool("report_by_exception", false));
+    scada->SetStaggeredPolling(config.GetBool("staggered", false));
+
+    if (config.Has("max_concurrent_polls"))
+        scada->SetMaxConcurrentPolls(config["max_concurrent_polls"].AsNumber());
+
+    m_Builder->AddToNetwork(scada);
+    m_Scadas.push_back(scada);
+}
+
+void
+Scenario::ConnectScada(ScadaApplication &scada, const JsonValue &config)
+{
+    if (!config.Has("rtus"))
+        return;
+
+    for (const JsonValue &rtu : config["rtus"].AsArray())
+    {
+        // Hosted PLCs are reached through the address of their host
+        const Endpoint &endpoint = m_Endpoints[GetPlcIndex(rtu["plc"].AsString())];
+        auto uid = static_cast<uint8_t>(rtu.GetNumber("uid", endpoint.uid));
+
+        size_t handle = scada.AddRTU(endpoint.app->GetAddress(), uid);
+
+        if (!rtu.Has("tags"))
+            continue;
+
+        for (const JsonValue &tag : rtu["tags"].AsArray())
+        {
+            scada.AddVariable(handle,
+                              tag["name"].AsString(),
+                              ParseVarType(tag["type"].AsString()),
+                              tag["pos"].AsNumber());
+
+            if (tag.Has("deadband"))
+                scada.SetDeadband(tag["name"].AsString(), tag["deadband"].AsNumber());
+        }
+    }
+}
+
+void
+Scenario::SetupRunner(const JsonValue &document)
+{
+    std::string mode = document.GetString("run_mode", "unpaced");
+
+    if (mode == "paced")
+        SimulationRunner::SetMode(RunMode::Paced);
+    else if (mode == "unpaced")
+        SimulationRunner::SetMode(RunMode::Unpaced);
+    else
+        NS_FATAL_ERROR("Unknown run mode '" << mode << "' (expected paced or unpaced)");
+
+    if (document.Has("pacing"))
+    {
+        const JsonValue &pacing = document["pacing"];
+        SimulationRunner::SetPacing(pacing.GetNumber("scale", 1), pacing.GetNumber("interval", 10));
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "historian.h"
+#include "industrial-network-builder.h"
+#include "json.h"
+#include "plc-host.h"
+#include "stats-publisher.h"
+
+#include <memory>
+#include <unordered_map>
+
+/**
+ * A simulation described by a scenario file
+ *
+ * The file is a JSON document with the network, the PLCs (with the native
+ * process models they control), the SCADAs with their RTUs and tags, and
+ * how long to run:
+ *
+ *  {
+ *    "network": {"address": "192.168.1.0", "mask": "255.255.255.0", "pcap": "sim",
+ *                "verbose": true, "register_names": true, "lightweight_stack": false},
+ *    "refresh_rate": 50,
+ *    "duration": 100,
+ *    "run_mode": "unpaced",
+ *    "stats": {"name": "/tinyics", "period": 100},
+ *    "plcs": [
+ *      {
+ *        "name": "wt",
+ *        "process": {
+ *          "kernel": "tank",
+ *          "integrator": "rk4",
+ *          "max_step": 0.01,
+ *          "tolerance": 1e-6,
+ *          "relative_tolerance": 1e-6,
+ *          "state": [0],
+ *          "parameters": [0.1, 0.05, 1, 0, 1],
+ *          "sensors": [{"state": 0, "port": 0, "min": 0, "max": 10}]
+ *        }
+ *      }
+ *    ],
+ *    "hosts": [
+ *      {"name": "rack", "units": [{"uid": 1, "name": "p1"}, {"uid": 2, "name": "p2"}]}
+ *    ],
+ *    "scadas": [
+ *      {
+ *        "name": "scada",
+ *        "rate": 500,
+ *        "rtus": [
+ *          {"plc": "wt", "uid": 1, "tags": [{"name": "pump", "type": "coil", "pos": 0}]}
+ *        ]
+ *      }
+ *    ]
+ *  }
+ *
+ * The PLCs of a host share its node and are told apart by unit id (see
+ * PlcHost), RTUs refer to them by name like to any other PLC. A SCADA with
+ * a "historian" section ({"retention": 3600, "memory_limit": 1048576,
+ * "on_change": false}) is a Historian recording its tags. With "stats"
+ * the run is published for tinyics-stats (see StatsPublisher), every SCADA
+ * is watched.
+ *
+ * Every device is created, added to the network and wired to its RTUs in
+ * a single pass, without going through Python. Process kernels are looked
+ * up by name (see ContinuousProcess::RegisterKernel), besides the ones
+ * registered by the application the following are built in:
+ *
+ *  - "tank": level of a tank, parameters [inflow, outflow, area, inlet coil,
+ *    outlet coil], the flows only run while their coil is on.
+ *  - "first_order": first order lag towards a setpoint, parameters [gain,
+ *    time constant, coil], the setpoint is the gain while the coil is on and
+ *    0 otherwise.
+ *
+ * A process must list at least as many parameters as its kernel reads. The
+ * "tolerance" of the adaptive integrator applies to both the absolute and
+ * the relative error, unless "relative_tolerance" is also given.
+ */
+class Scenario
+{
+public:
+    /// Load the scenario file and build its network
+    static std::unique_ptr<Scenario> Load(const std::string &path);
+
+    /**
+     * Build the scenario from an already parsed document, `source` is used
+     * to report errors (e.g. the file name)
+     */
+    static std::unique_ptr<Scenario> Load(const JsonValue &document,
+                                          const std::string &source = "json");
+
+    /// Run the simulation for the duration of the scenario and destroy it
+    void Run();
+
+    /// Simulated seconds the scenario runs for
+    double GetDuration() const;
+
+    ns3::Ptr<PlcApplication> GetPlc(const std::string &name) const;
+
+    ns3::Ptr<ScadaApplication> GetScada(const std::string &name) const;
+
+    const std::vector<ns3::Ptr<PlcApplication>> &GetPlcs() const;
+
+    const std::vector<ns3::Ptr<ScadaApplication>> &GetScadas() const;
+
+    /// Time and memory spent building the network of the scenario
+    const BuildProfile &GetBuildProfile() const;
+
+private:
+    Scenario() = default;
+
+    /// Create a PLC and the process it controls (without adding it to the network)
+    ns3::Ptr<PlcApplication> CreatePlc(const JsonValue &plc);
+
+    /// Create a PLC host and the PLCs it serves
+    void AddHost(const JsonValue &host);
+
+    size_t GetPlcIndex(const std::string &name) const;
+
+    /// Create a SCADA and set it up (the RTUs are added once addresses are known)
+    void AddScada(const JsonValue &scada);
+
+    /// Add the RTUs and tags of a SCADA
+    void ConnectScada(ScadaApplication &scada, const JsonValue &config);
+
+    /// Apply the run mode and pacing of the scenario
+    void SetupRunner(const JsonValue &document);
+
+    std::unique_ptr<IndustrialNetworkBuilder> m_Builder;
+    std::vector<ns3::Ptr<PlcApplication>> m_Plcs;
+    std::unordered_map<std::string, size_t> m_PlcByName; //!< Index in m_Plcs, for the RTUs
+
+    /// Where each PLC (same index as m_Plcs) is reached on the network
+    struct Endpoint
+    {
+        ns3::Ptr<IndustrialApplication> app; //!< The PLC itself or its host
+        uint8_t uid;
+    };
+
+    std::vector<Endpoint> m_Endpoints;
+    std::vector<ns3::Ptr<ScadaApplication>> m_Scadas;
+    double m_Duration = 0;
+    std::string m_Source; //!< Name of the document, for errors
+};
@@ -0,0 +1,217 @@
+#include "sensor-model.h"
+
+#include "ns3/simulator.h"
+
+#include <cmath>
+
+namespace
+{
+
+/// Philox4x32 multipliers and key increments (Salmon et al., SC'11)
+constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+constexpr uint32_t PHILOX_W0 = 0x9E3779B9;
+constexpr uint32_t PHILOX_W1 = 0xBB67AE85;
+
+/// Philox4x32-10, 4 random words for the given counter and key
+std::array<uint32_t, 4>
+Philox(std::array<uint32_t, 4> ctr, std::array<uint32_t, 2> key)
+{
+    for (int round = 0; round < 10; round++)
+    {
+        uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * ctr[0];
+        uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * ctr[2];
+
+        ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+               static_cast<uint32_t>(p1),
+               static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+               static_cast<uint32_t>(p0)};
+
+        key[0] += PHILOX_W0;
+        key[1] += PHILOX_W1;
+    }
+
+    return ctr;
+}
+
+/// Mix the bits of a 64 bit value (SplitMix64 finalizer)
+uint64_t
+Mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+uint64_t SensorModel::s_RunSeed = 0;
+
+SensorModel::SensorModel(uint64_t id)
+    : m_Id(id)
+{
+}
+
+void
+SensorModel::SetRunSeed(uint64_t seed)
+{
+    s_RunSeed = seed;
+}
+
+uint64_t
+SensorModel::GetRunSeed()
+{
+    return s_RunSeed;
+}
+
+void
+SensorModel::SetNoise(double stdDev)
+{
+    m_Noise = stdDev;
+}
+
+void
+SensorModel::SetQuantization(double step)
+{
+    m_Quantization = step;
+}
+
+void
+SensorModel::SetBias(double bias)
+{
+    m_Bias = bias;
+}
+
+void
+SensorModel::SetDrift(double perSecond)
+{
+    m_Drift = perSecond;
+}
+
+void
+SensorModel::SetStuckProbability(double probability)
+{
+    m_StuckProbability = probability;
+}
+
+void
+SensorModel::Stick(double value)
+{
+    m_Stuck = true;
+    m_StuckValue = value;
+}
+
+void
+SensorModel::Unstick()
+{
+    m_Stuck = false;
+}
+
+bool
+SensorModel::IsStuck() const
+{
+    return m_Stuck;
+}
+
+uint64_t
+SensorModel::GetId() const
+{
+    return m_Id;
+}
+
+uint64_t
+SensorModel::GetSampleCount() const
+{
+    return m_Samples;
+}
+
+double
+SensorModel::Sample(double value)
+{
+    uint64_t block = m_Samples / SM_BLOCK_SZ;
+
+    if (block != m_Block || m_Seed != s_RunSeed)
+    {
+        m_Block = block;
+        Refill();
+    }
+
+    // Every sample takes its random numbers, stuck or not, so the stream
+    // position only depends on the amount of samples
+    size_t i = m_Samples % SM_BLOCK_SZ;
+    m_Samples++;
+
+    if (m_Stuck)
+        return m_StuckValue;
+
+    value += m_Bias + m_Drift * ns3::Simulator::Now().GetSeconds();
+    value += m_Noise * m_Gaussian[i];
+
+    if (m_Quantization > 0)
+        value = std::round(value / m_Quantization) * m_Quantization;
+
+    if (m_Uniform[i] < m_StuckProbability)
+        Stick(value);
+
+    return value;
+}
+
+void
+SensorModel::Serialize(SnapshotWriter &writer) const
+{
+    writer.Write(m_Id);
+    writer.Write(m_Samples);
+    writer.Write(m_Noise);
+    writer.Write(m_Quantization);
+    writer.Write(m_Bias);
+    writer.Write(m_Drift);
+    writer.Write(m_StuckProbability);
+    writer.Write(m_Stuck);
+    writer.Write(m_StuckValue);
+}
+
+void
+SensorModel::Deserialize(SnapshotReader &reader)
+{
+    m_Id = reader.Read<uint64_t>();
+    m_Samples = reader.Read<uint64_t>();
+    m_Noise = reader.Read<double>();
+    m_Quantization = reader.Read<double>();
+    m_Bias = reader.Read<double>();
+    m_Drift = reader.Read<double>();
+    m_StuckProbability = reader.Read<double>();
+    m_Stuck = reader.Read<bool>();
+    m_StuckValue = reader.Read<double>();
+
+    // The block of the restored position is generated on the next sample
+    m_Block = UINT64_MAX;
+}
+
+void
+SensorModel::Refill()
+{
+    m_Seed = s_RunSeed;
+
+    // The stream of the sensor is selected by the key, the sample by the counter
+    uint64_t stream = Mix(m_Seed ^ Mix(m_Id));
+    std::array<uint32_t, 2> key = {static_cast<uint32_t>(stream),
+                                   static_cast<uint32_t>(stream >> 32)};
+
+    for (size_t i = 0; i < SM_BLOCK_SZ; i++)
+    {
+        uint64_t sample = m_Block * SM_BLOCK_SZ + i;
+        auto words = Philox({static_cast<uint32_t>(sample),
+                             static_cast<uint32_t>(sample >> 32), 0, 0},
+                            key);
+
+        // Uniform in (0, 1] from 53 bits (so the log is finite) and in [0, 1) from 32 bits
+        uint64_t bits = (static_cast<uint64_t>(words[1]) << 32 | words[0]) >> 11;
+        double u1 = (bits + 1) * 0x1.0p-53;
+        double u2 = words[2] * 0x1.0p-32;
+
+        // Box-Muller, only the cosine branch so each sample has its own counter
+        m_Gaussian[i] = std::sqrt(-2 * std::log(u1)) * std::cos(2 * M_PI * u2);
+        m_Uniform[i] = words[3] * 0x1.0p-32;
+    }
+}
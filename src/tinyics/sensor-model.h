@@ -0,0 +1,118 @@
+#pragma once
+
+#include "snapshot.h"
+
+#include <array>
+#include <cstdint>
+
+// Samples generated on each refill of the noise block
+#define SM_BLOCK_SZ 16
+
+/*
+ * Imperfections of a real sensor applied to the value it measures
+ *
+ * Supports a constant bias, a linear bias drift over simulated time,
+ * gaussian noise, quantization of the output and stuck-at faults (set
+ * manually or starting at random).
+ *
+ * The randomness comes from a counter-based generator (Philox4x32-10), the
+ * n-th sample of a sensor only depends on the run seed, the id of the
+ * sensor and n. So the results are reproducible and don't depend on the
+ * order in which sensors are read, or on how many other sensors exist.
+ * Samples are generated in blocks of SM_BLOCK_SZ.
+ */
+class SensorModel
+{
+public:
+    /*
+     * The id selects the random stream of the sensor, it must be unique
+     * among the sensors of a simulation
+     */
+    explicit SensorModel(uint64_t id);
+
+    /*
+     * Seed shared by all the sensor models of the run (0 by default)
+     */
+    static void SetRunSeed(uint64_t seed);
+
+    static uint64_t GetRunSeed();
+
+    /*
+     * Standard deviation of the gaussian noise (in engineering units)
+     */
+    void SetNoise(double stdDev);
+
+    /*
+     * Smallest change the sensor reports, 0 disables quantization
+     */
+    void SetQuantization(double step);
+
+    /*
+     * Constant offset added to the measured value
+     */
+    void SetBias(double bias);
+
+    /*
+     * Change of the bias per second of simulated time
+     */
+    void SetDrift(double perSecond);
+
+    /*
+     * Probability of the sensor getting stuck at its current output on
+     * each sample
+     */
+    void SetStuckProbability(double probability);
+
+    /*
+     * Force the sensor to report the given value until Unstick is called
+     */
+    void Stick(double value);
+
+    void Unstick();
+
+    bool IsStuck() const;
+
+    uint64_t GetId() const;
+
+    /*
+     * Amount of samples taken from the sensor
+     */
+    uint64_t GetSampleCount() const;
+
+    /*
+     * Take the next sample of the sensor for the true value
+     */
+    double Sample(double value);
+
+    /*
+     * Store the settings and the position in the random stream, the
+     * random numbers are generated again from them when restored
+     */
+    void Serialize(SnapshotWriter &writer) const;
+
+    void Deserialize(SnapshotReader &reader);
+
+private:
+    /// Generate the random numbers of the block the next sample belongs to
+    void Refill();
+
+    static uint64_t s_RunSeed;
+
+    uint64_t m_Id;
+    uint64_t m_Samples = 0;
+
+    double m_Noise = 0;
+    double m_Quantization = 0;
+    double m_Bias = 0;
+    double m_Drift = 0;
+    double m_StuckProbability = 0;
+
+    bool m_Stuck = false;
+    double m_StuckValue = 0;
+
+    // Random numbers of the current block
+    uint64_t m_Block = UINT64_MAX; //!< Index of the block, none generated yet
+    uint64_t m_Seed = 0;           //!< Run seed the block was generated with
+    std::array<double, SM_BLOCK_SZ> m_Gaussian;
+    std::array<double, SM_BLOCK_SZ> m_Uniform;
+};
@@ -1,5 +1,10 @@
 #pragma once
 
+#include "sensor-model.h"
+#include "snapshot.h"
+
+#include <memory>
+
 class AnalogSensor
 {
 public:
@@ -84,13 +89,25 @@ public:
     }
 
     /*
-     * Returns the value of the measured input in the range 4-20mA
+     * Returns the current of the loop for the measured input, 4mA at the
+     * minimum and 20mA at the maximum (not clamped, so an out of range
+     * value can be detected by the PLC)
+     *
+     * With a model attached it's computed from the last sample (see Sample).
      */
-    double GetOutputValue() const
+    double GetLoopCurrent() const
     {
         // (20mA - 4mA) / (max - min)
         auto scalingFactor = 16 / (m_Max - m_Min);
-        auto current = ((m_Value - m_Min) * scalingFactor) + 4;
+        return ((GetMeasuredValue() - m_Min) * scalingFactor) + 4;
+    }
+
+    /*
+     * Returns the value of the measured input in the range 4-20mA
+     */
+    double GetOutputValue() const
+    {
+        auto current = GetLoopCurrent();
 
         // Clamp the values in the range 4-20
         if (current > 20)
@@ -108,6 +125,41 @@ public:
         return m_Value;
     }
 
+    /*
+     * The value reported by the sensor, the last sample of the true value
+     * with the imperfections of the model applied (if there's one)
+     */
+    double GetMeasuredValue() const
+    {
+        return m_Model ? m_Measured : m_Value;
+    }
+
+    /*
+     * Take a new sample of the sensor, which the getters report until the
+     * next one. The plant takes one on every update, when the process
+     * stores the sensor into the PLC (see PlcState::SetAnalogState).
+     */
+    double Sample()
+    {
+        m_Measured = m_Model ? m_Model->Sample(m_Value) : m_Value;
+        return m_Measured;
+    }
+
+    /*
+     * Attach a model of noise, drift, quantization and faults, copies of
+     * the sensor share it. Until the next sample the true value is reported.
+     */
+    void SetModel(std::shared_ptr<SensorModel> model)
+    {
+        m_Model = std::move(model);
+        m_Measured = m_Value;
+    }
+
+    std::shared_ptr<SensorModel> GetModel() const
+    {
+        return m_Model;
+    }
+
     /*
      * Set the measured value, the original value measured by the sensor (could
      * represent temperature, presion, etc.)
@@ -117,9 +169,35 @@ public:
         m_Value = value;
     }
 
+    double GetMin() const
+    {
+        return m_Min;
+    }
+
+    double GetMax() const
+    {
+        return m_Max;
+    }
+
+    void Serialize(SnapshotWriter& writer) const
+    {
+        writer.Write(m_Value);
+        writer.Write(m_Min);
+        writer.Write(m_Max);
+    }
+
+    void Deserialize(SnapshotReader& reader)
+    {
+        m_Value = reader.Read<double>();
+        m_Min = reader.Read<double>();
+        m_Max = reader.Read<double>();
+    }
+
 private:
     double m_Value;
     double m_Min;
     double m_Max;
+    double m_Measured = 0; //!< Last sample taken from the model
+    std::shared_ptr<SensorModel> m_Model;
 };
 
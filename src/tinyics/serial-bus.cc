@@ -0,0 +1,174 @@
+#include "serial-bus.h"
+
+#include "ns3/simulator.h"
+
+#include "modbus-rtu.h"
+
+SerialBus::SerialBus(uint32_t baud, uint8_t bitsPerChar)
+    : m_BitsPerChar(bitsPerChar)
+{
+    SetBaudRate(baud);
+}
+
+void
+SerialBus::SetBaudRate(uint32_t baud)
+{
+    if (baud == 0)
+        NS_FATAL_ERROR("The baud rate of the serial bus should be greater than zero");
+
+    m_Baud = baud;
+}
+
+void
+SerialBus::SetTurnaround(ns3::Time turnaround)
+{
+    m_Turnaround = turnaround;
+}
+
+ns3::Time
+SerialBus::GetTurnaround() const
+{
+    return m_Turnaround;
+}
+
+void
+SerialBus::AttachSlave(uint8_t address, ns3::Ptr<PlcApplication> plc)
+{
+    if (address == 0 || address > 247)
+        NS_FATAL_ERROR("Modbus RTU slave address should be in the range 1 to 247, got "
+                       << (int)address);
+
+    if (!m_Slaves.emplace(address, plc).second)
+        NS_FATAL_ERROR("Address " << (int)address << " already in use on the serial bus");
+}
+
+void
+SerialBus::SetMasterCallback(ns3::Callback<void, std::vector<uint8_t>> receive)
+{
+    m_Master = receive;
+}
+
+ns3::Time
+SerialBus::GetCharTime() const
+{
+    return ns3::NanoSeconds(1000000000ull * m_BitsPerChar / m_Baud);
+}
+
+ns3::Time
+SerialBus::GetSilentInterval() const
+{
+    // Above 19200 baud the specification fixes the interval instead of scaling it
+    if (m_Baud > 19200)
+        return ns3::MicroSeconds(1750);
+
+    return ns3::NanoSeconds(GetCharTime().GetNanoSeconds() * 7 / 2);
+}
+
+ns3::Time
+SerialBus::GetFrameTime(uint32_t size) const
+{
+    return ns3::NanoSeconds(1000000000ull * m_BitsPerChar * size / m_Baud);
+}
+
+ns3::Time
+SerialBus::Occupy(uint32_t size)
+{
+    ns3::Time now = ns3::Simulator::Now();
+    ns3::Time start = m_IdleAt > now ? m_IdleAt : now;
+    ns3::Time duration = GetFrameTime(size);
+
+    m_IdleAt = start + duration + GetSilentInterval();
+    m_BusyTime += duration;
+    m_Frames++;
+
+    return start + duration;
+}
+
+ns3::Time
+SerialBus::Send(const std::vector<uint8_t> &frame)
+{
+    ns3::Time end = Occupy(frame.size());
+
+    ns3::Simulator::Schedule(end - ns3::Simulator::Now(),
+                             &SerialBus::DeliverToSlaves,
+                             this,
+                             frame);
+    return end;
+}
+
+void
+SerialBus::DeliverToSlaves(std::vector<uint8_t> frame)
+{
+    uint8_t address = frame.empty() ? 0 : frame[0];
+
+    ModbusADU request;
+    if (!ModbusRTU::Decode(frame, 0, request))
+    {
+        m_Discarded++;
+        return;
+    }
+
+    std::vector<ModbusADU> responses;
+
+    // Broadcasts are executed by everyone and never answered
+    if (address == 0)
+    {
+        for (auto &[addr, slave] : m_Slaves)
+            slave->ProcessRequest(request, responses);
+
+        return;
+    }
+
+    auto slave = m_Slaves.find(address);
+    if (slave == m_Slaves.end())
+    {
+        m_Discarded++;
+        return;
+    }
+
+    slave->second->ProcessRequest(request, responses);
+
+    // The slave waits for its turnaround time and for the line to go idle
+    for (const ModbusADU &response : responses)
+    {
+        std::vector<uint8_t> reply = ModbusRTU::Encode(response);
+
+        m_IdleAt = std::max(m_IdleAt, ns3::Simulator::Now() + m_Turnaround);
+        ns3::Time end = Occupy(reply.size());
+
+        ns3::Simulator::Schedule(end - ns3::Simulator::Now(),
+                                 &SerialBus::DeliverToMaster,
+                                 this,
+                                 reply);
+    }
+}
+
+void
+SerialBus::DeliverToMaster(std::vector<uint8_t> frame)
+{
+    if (!m_Master.IsNull())
+        m_Master(frame);
+}
+
+uint64_t
+SerialBus::GetFrameCount() const
+{
+    return m_Frames;
+}
+
+uint64_t
+SerialBus::GetDiscardedCount() const
+{
+    return m_Discarded;
+}
+
+double
+SerialBus::GetUtilization() const
+{
+    ns3::Time elapsed = ns3::Simulator::Now();
+
+    if (elapsed.IsZero())
+        return 0;
+
+    return m_BusyTime.GetSeconds() / elapsed.GetSeconds();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "ns3/callback.h"
+#include "ns3/nstime.h"
+
+#include "plc-application.h"
+
+/**
+ * Half-duplex RS-485 multidrop segment running Modbus RTU.
+ *
+ * A single master (e.g. a ModbusRtuGateway) talks to the slaves attached
+ * to the bus, the slaves are PLCs that are not part of the IP network and
+ * are only reachable through the bus. Frames take their real time on the
+ * wire: every character is `bitsPerChar / baud` seconds long and frames are
+ * separated by a silent interval of 3.5 characters (fixed to 1.75 ms above
+ * 19200 baud, as the serial line specification recommends). Only one frame
+ * is on the wire at a time.
+ *
+ * Frames with a bad CRC are ignored by the receiver, broadcasts (address 0)
+ * are executed by every slave and never answered.
+ */
+class SerialBus
+{
+public:
+    /**
+     * \param baud bits per second on the line
+     * \param bitsPerChar bits sent per byte (start, 8 data, parity and stop bits)
+     */
+    SerialBus(uint32_t baud = 19200, uint8_t bitsPerChar = 11);
+
+    void SetBaudRate(uint32_t baud);
+
+    /// Time the slaves take to start answering a request (or to execute a broadcast)
+    void SetTurnaround(ns3::Time turnaround);
+
+    ns3::Time GetTurnaround() const;
+
+    /// Attach the PLC to the bus as the slave with the given address (1 to 247)
+    void AttachSlave(uint8_t address, ns3::Ptr<PlcApplication> plc);
+
+    /// Called with every frame a slave sends back to the master
+    void SetMasterCallback(ns3::Callback<void, std::vector<uint8_t>> receive);
+
+    /**
+     * Send a frame from the master
+     *
+     * The frame goes on the wire as soon as the bus is idle.
+     *
+     * returns the time at which the frame is fully received by the slaves
+     */
+    ns3::Time Send(const std::vector<uint8_t> &frame);
+
+    /// Time it takes to send a single character
+    ns3::Time GetCharTime() const;
+
+    /// Minimum idle time between frames
+    ns3::Time GetSilentInterval() const;
+
+    /// Time it takes to send a frame of the given size
+    ns3::Time GetFrameTime(uint32_t size) const;
+
+    uint64_t GetFrameCount() const;
+
+    /// Frames discarded because of a bad CRC or an unknown address
+    uint64_t GetDiscardedCount() const;
+
+    /// Fraction of the elapsed simulated time the bus was transmitting
+    double GetUtilization() const;
+
+private:
+    /// Reserve the bus for the frame, returns the time the transmission ends
+    ns3::Time Occupy(uint32_t size);
+
+    /// A request from the master finished arriving at the slaves
+    void DeliverToSlaves(std::vector<uint8_t> frame);
+
+    /// A response from a slave finished arriving at the master
+    void DeliverToMaster(std::vector<uint8_t> frame);
+
+    uint32_t m_Baud;
+    uint8_t m_BitsPerChar;
+    ns3::Time m_Turnaround;
+    ns3::Time m_IdleAt;                                    //!< When the bus can take a new frame
+    ns3::Time m_BusyTime;                                  //!< Total time spent transmitting
+    std::map<uint8_t, ns3::Ptr<PlcApplication>> m_Slaves; //!< Address -> slave
+    ns3::Callback<void, std::vector<uint8_t>> m_Master;
+    uint64_t m_Frames = 0;
+    uint64_t m_Discarded = 0;
+};
@@ -0,0 +1,112 @@
+#include "simulation-runner.h"
+
+#include "ns3/fatal-error.h"
+#include "ns3/simulator.h"
+
+#include <thread>
+
+RunMode SimulationRunner::s_Mode = RunMode::Unpaced;
+double SimulationRunner::s_Scale = 1.0;
+uint64_t SimulationRunner::s_Interval = 10;
+SimulationRunner::Clock::time_point SimulationRunner::s_Start;
+double SimulationRunner::s_TotalLag = 0;
+RunMetrics SimulationRunner::s_Metrics;
+RunMetrics SimulationRunner::s_Published;
+std::mutex SimulationRunner::s_MetricsMutex;
+
+void
+SimulationRunner::SetMode(RunMode mode)
+{
+    s_Mode = mode;
+}
+
+void
+SimulationRunner::SetPacing(double scale, uint64_t interval)
+{
+    if (scale <= 0 || interval == 0)
+        NS_FATAL_ERROR("Pacing scale and interval should be greater than zero");
+
+    s_Scale = scale;
+    s_Interval = interval;
+}
+
+void
+SimulationRunner::Run(double time)
+{
+    s_Metrics = RunMetrics();
+    s_TotalLag = 0;
+    PublishMetrics();
+
+    ns3::Simulator::Stop(ns3::Seconds(time));
+    ns3::Simulator::ScheduleNow(&SimulationRunner::Tick);
+
+    s_Start = Clock::now();
+    ns3::Simulator::Run();
+
+    UpdateMetrics();
+    PublishMetrics();
+    ns3::Simulator::Destroy();
+}
+
+RunMetrics
+SimulationRunner::GetMetrics()
+{
+    std::lock_guard<std::mutex> lock(s_MetricsMutex);
+    return s_Published;
+}
+
+void
+SimulationRunner::Discount(Clock::duration duration)
+{
+    s_Start += duration;
+}
+
+void
+SimulationRunner::Tick()
+{
+    UpdateMetrics();
+
+    if (s_Mode == RunMode::Paced)
+    {
+        // Wall clock time at which the simulation should reach the current time
+        double target = s_Metrics.simulatedTime / s_Scale;
+        double lag = s_Metrics.wallTime - target;
+
+        if (lag < 0)
+        {
+            std::this_thread::sleep_until(
+                s_Start + std::chrono::duration_cast<Clock::duration>(
+                              std::chrono::duration<double>(target)));
+            lag = 0;
+        }
+
+        if (lag * s_Scale > s_Interval / 1000.0)
+            s_Metrics.overruns++;
+
+        s_TotalLag += lag;
+        s_Metrics.lag = lag;
+        s_Metrics.maxLag = std::max(s_Metrics.maxLag, lag);
+        s_Metrics.meanLag = s_TotalLag / (s_Metrics.ticks + 1);
+    }
+
+    s_Metrics.ticks++;
+    PublishMetrics();
+
+    ns3::Simulator::Schedule(ns3::MilliSeconds(s_Interval), &SimulationRunner::Tick);
+}
+
+void
+SimulationRunner::UpdateMetrics()
+{
+    s_Metrics.simulatedTime = ns3::Simulator::Now().GetSeconds();
+    s_Metrics.wallTime = std::chrono::duration<double>(Clock::now() - s_Start).count();
+    s_Metrics.speedup = s_Metrics.wallTime > 0 ? s_Metrics.simulatedTime / s_Metrics.wallTime : 0;
+    s_Metrics.events = ns3::Simulator::GetEventCount();
+}
+
+void
+SimulationRunner::PublishMetrics()
+{
+    std::lock_guard<std::mutex> lock(s_MetricsMutex);
+    s_Published = s_Metrics;
+}
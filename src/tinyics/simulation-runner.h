@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * How the simulated clock relates to the wall clock
+ */
+enum class RunMode
+{
+    Unpaced, //!< Run as fast as possible (batch work)
+    Paced,   //!< Keep the simulated clock in step with the wall clock
+};
+
+/**
+ * Live metrics of the running simulation.
+ *
+ * Lag is how far the simulation is behind the wall clock schedule, it is
+ * only measured in paced mode. A scenario that keeps up in real time has
+ * a lag close to zero, a growing lag means it is too heavy for the pace.
+ */
+struct RunMetrics
+{
+    double simulatedTime = 0; //!< Simulated seconds elapsed
+    double wallTime = 0;      //!< Wall clock seconds elapsed
+    double speedup = 0;       //!< Simulated seconds per wall clock second
+    double lag = 0;           //!< Current lag behind the schedule in seconds
+    double maxLag = 0;        //!< Worst lag seen
+    double meanLag = 0;       //!< Average lag over all pacing ticks
+    uint64_t ticks = 0;       //!< Pacing ticks executed
+    uint64_t overruns = 0;    //!< Ticks that were already late by more than one interval
+    uint64_t events = 0;      //!< Simulator events executed
+};
+
+/**
+ * Runs the simulation in one of the RunMode and keeps track of its
+ * RunMetrics.
+ *
+ * Pacing is done by a tinyics-level loop: an event every pacing interval
+ * compares the simulated time with the wall clock and sleeps until they
+ * match, or records the lag when the simulation is behind. In both modes
+ * the metrics are refreshed on every tick, so they can be read while the
+ * simulation runs (also from another thread, see AsyncRunner).
+ */
+class SimulationRunner
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static void SetMode(RunMode mode);
+
+    /**
+     * Set the pacing parameters
+     *
+     * \param scale simulated seconds per wall clock second (1 is real time)
+     * \param interval simulated milliseconds between pacing ticks
+     */
+    static void SetPacing(double scale, uint64_t interval);
+
+    /// Run the simulation for the given amount of seconds and destroy it
+    static void Run(double time);
+
+    /// Copy of the metrics as of the last tick, safe to call from any thread
+    static RunMetrics GetMetrics();
+
+    /// Leave wall clock time out of the pacing and metrics (e.g. while paused)
+    static void Discount(Clock::duration duration);
+
+private:
+    /// Pacing loop, reschedules itself every interval
+    static void Tick();
+
+    static void UpdateMetrics();
+
+    /// Make the metrics of the simulation thread visible to GetMetrics
+    static void PublishMetrics();
+
+    static RunMode s_Mode;
+    static double s_Scale;
+    static uint64_t s_Interval;
+    static Clock::time_point s_Start;
+    static double s_TotalLag;
+    static RunMetrics s_Metrics;   //!< Only used by the simulation thread
+    static RunMetrics s_Published; //!< Guarded by s_MetricsMutex
+    static std::mutex s_MetricsMutex;
+};
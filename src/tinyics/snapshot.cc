@@ -0,0 +1,97 @@
+#include "snapshot.h"
+
+#include "industrial-plant.h"
+
+#include "ns3/simulator.h"
+
+#include <fstream>
+#include <sstream>
+
+void
+SnapshotWriter::WriteString(const std::string &value)
+{
+    Write<uint32_t>(value.size());
+    m_Buffer.append(value);
+}
+
+const std::string &
+SnapshotWriter::GetBuffer() const
+{
+    return m_Buffer;
+}
+
+SnapshotReader::SnapshotReader(std::string buffer)
+    : m_Buffer(std::move(buffer))
+{
+}
+
+std::string
+SnapshotReader::ReadString()
+{
+    uint32_t size = Read<uint32_t>();
+
+    if (m_Pos + size > m_Buffer.size())
+        NS_FATAL_ERROR("Snapshot is truncated or corrupted");
+
+    std::string value = m_Buffer.substr(m_Pos, size);
+    m_Pos += size;
+
+    return value;
+}
+
+bool
+SnapshotReader::AtEnd() const
+{
+    return m_Pos >= m_Buffer.size();
+}
+
+void
+SimulationSnapshot::Save(const std::string &path)
+{
+    SnapshotWriter writer;
+    writer.Write(s_Magic);
+    writer.Write(s_Version);
+    writer.Write<int64_t>(ns3::Simulator::Now().GetNanoSeconds());
+
+    IndustrialPlant::Serialize(writer);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        NS_FATAL_ERROR("Could not open '" << path << "' to save the snapshot");
+
+    const std::string &buffer = writer.GetBuffer();
+    file.write(buffer.data(), buffer.size());
+}
+
+void
+SimulationSnapshot::Load(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        NS_FATAL_ERROR("Could not open snapshot '" << path << '\'');
+
+    std::stringstream content;
+    content << file.rdbuf();
+
+    SnapshotReader reader(content.str());
+
+    if (reader.Read<uint32_t>() != s_Magic)
+        NS_FATAL_ERROR("'" << path << "' is not a tinyics snapshot");
+
+    auto version = reader.Read<uint16_t>();
+    if (version != s_Version)
+        NS_FATAL_ERROR("Unsupported snapshot version " << version << " in '" << path << '\'');
+
+    auto time = reader.Read<int64_t>();
+    std::clog << "Restoring snapshot taken at " << ns3::NanoSeconds(time).GetSeconds() << "s\n";
+
+    IndustrialPlant::Deserialize(reader);
+}
+
+void
+SimulationSnapshot::ScheduleSave(double time, const std::string &path)
+{
+    ns3::Simulator::Schedule(ns3::Seconds(time) - ns3::Simulator::Now(),
+                             &SimulationSnapshot::Save,
+                             path);
+}
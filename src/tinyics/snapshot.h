@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "ns3/fatal-error.h"
+
+/**
+ * Appends values to a binary snapshot buffer.
+ *
+ * Values are stored in host byte order, snapshots are meant to be
+ * restored on the same kind of machine that produced them.
+ */
+class SnapshotWriter
+{
+public:
+    template <typename T>
+    void Write(const T &value);
+
+    /// Write a length prefixed string (or any blob of bytes)
+    void WriteString(const std::string &value);
+
+    const std::string &GetBuffer() const;
+
+private:
+    std::string m_Buffer;
+};
+
+/**
+ * Reads values back from a binary snapshot buffer.
+ *
+ * Reading past the end of the buffer is a fatal error, since it means the
+ * snapshot is corrupted or doesn't match the scenario being restored.
+ */
+class SnapshotReader
+{
+public:
+    SnapshotReader(std::string buffer);
+
+    template <typename T>
+    T Read();
+
+    std::string ReadString();
+
+    bool AtEnd() const;
+
+private:
+    std::string m_Buffer;
+    size_t m_Pos = 0;
+};
+
+/**
+ * Checkpoint of the tinyics-level state of a simulation.
+ *
+ * It stores the in/out state of every PLC, the state of the processes they
+ * control (through IndustrialProcess::Serialize), and the tag store and
+ * transaction ids of every SCADA. Loading a snapshot into a freshly built
+ * scenario lets it skip its warm-up phase. Devices are matched by name.
+ */
+class SimulationSnapshot
+{
+public:
+    static void Save(const std::string &path);
+
+    static void Load(const std::string &path);
+
+    /// Save a snapshot when the simulation reaches the given time (in seconds)
+    static void ScheduleSave(double time, const std::string &path);
+
+private:
+    static constexpr uint32_t s_Magic = 0x53434954; //!< "TICS" in little endian
+    static constexpr uint16_t s_Version = 2;
+};
+
+template <typename T>
+void
+SnapshotWriter::Write(const T &value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written");
+
+    m_Buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+T
+SnapshotReader::Read()
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read");
+
+    if (m_Pos + sizeof(T) > m_Buffer.size())
+        NS_FATAL_ERROR("Snapshot is truncated or corrupted");
+
+    T value;
+    memcpy(&value, m_Buffer.data() + m_Pos, sizeof(T));
+    m_Pos += sizeof(T);
+
+    return value;
+}
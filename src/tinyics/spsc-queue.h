@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Bounded lock-free queue for a single producer and a single consumer.
+ *
+ * A ring buffer with a power of two capacity. The producer only writes the
+ * tail and the consumer only the head, each on its own cache line, and each
+ * side caches the other's index so it only touches the shared one when the
+ * queue looks full (or empty). Push never blocks, it fails when full.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    /// The capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        m_Buffer.resize(size);
+        m_Mask = size - 1;
+    }
+
+    /// Called by the producer only, false if the queue is full
+    bool Push(const T &item)
+    {
+        size_t tail = m_Tail.load(std::memory_order_relaxed);
+
+        if (tail - m_CachedHead > m_Mask)
+        {
+            m_CachedHead = m_Head.load(std::memory_order_acquire);
+            if (tail - m_CachedHead > m_Mask)
+                return false;
+        }
+
+        m_Buffer[tail & m_Mask] = item;
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Called by the consumer only, false if the queue is empty
+    bool Pop(T &item)
+    {
+        size_t head = m_Head.load(std::memory_order_relaxed);
+
+        if (head == m_CachedTail)
+        {
+            m_CachedTail = m_Tail.load(std::memory_order_acquire);
+            if (head == m_CachedTail)
+                return false;
+        }
+
+        item = m_Buffer[head & m_Mask];
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Approximate amount of items queued
+    size_t GetSize() const
+    {
+        return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+    }
+
+    size_t GetCapacity() const
+    {
+        return m_Mask + 1;
+    }
+
+private:
+    static constexpr size_t s_CacheLine = 64;
+
+    std::vector<T> m_Buffer;
+    size_t m_Mask;
+
+    // Next item to pop and the consumer's copy of the tail, written by the consumer
+    alignas(s_CacheLine) std::atomic<size_t> m_Head{0};
+    size_t m_CachedTail = 0;
+
+    // Next slot to push and the producer's copy of the head, written by the producer
+    alignas(s_CacheLine) std::atomic<size_t> m_Tail{0};
+    size_t m_CachedHead = 0;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * Layout of the shared memory segment published by StatsPublisher.
+ *
+ * Only depends on the standard library so readers (like tinyics-stats) can
+ * map the segment without linking tinyics or ns-3. Any change to the layout
+ * must bump STATS_VERSION.
+ */
+
+#define STATS_MAGIC 0x53434954 // "TICS"
+#define STATS_VERSION 1
+
+// Maximum amount of RTUs reported, the rest are only counted in the totals
+#define STATS_MAX_RTUS 256
+
+// Size of the RTU labels, including the terminating null
+#define STATS_NAME_SZ 48
+
+/// Poll statistics of an RTU, latencies in milliseconds
+struct StatsRtu
+{
+    char name[STATS_NAME_SZ]; //!< "<scada>/<address>:<unit id>"
+    uint64_t requests;
+    uint64_t responses;
+    uint64_t timeouts;
+    uint32_t pending; //!< Transactions in flight or queued
+    double meanLatency;
+    double p99Latency;
+    double maxLatency;
+};
+
+/// Snapshot of a running simulation
+struct StatsData
+{
+    uint32_t finished;    //!< Set once the simulation was destroyed
+    double simulatedTime; //!< Simulated seconds elapsed
+    double wallTime;      //!< Wall clock seconds since the segment was opened
+    double speedup;       //!< Simulated seconds per wall clock second
+    uint64_t events;      //!< Simulator events executed
+    double eventRate;     //!< Events per wall clock second since the previous snapshot
+    uint64_t plantTicks;
+    double plantTickLast; //!< Milliseconds
+    double plantTickMean; //!< Milliseconds
+    double plantTickMax;  //!< Milliseconds
+    uint64_t pythonCalls;
+    double pythonTime;    //!< Seconds spent in Python overrides
+    uint64_t pendingTransactions;
+    uint32_t rtuCount;    //!< RTUs watched, may be more than STATS_MAX_RTUS
+    StatsRtu rtus[STATS_MAX_RTUS];
+};
+
+/**
+ * The segment, a seqlock around the data.
+ *
+ * The single writer makes the sequence odd while it copies a snapshot in and
+ * even once done. Readers never block the writer, they copy the data out and
+ * retry if the sequence was odd or changed while they copied.
+ */
+struct StatsBlock
+{
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint64_t> sequence;
+    StatsData data;
+
+    void Write(const StatsData &snapshot)
+    {
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(&data, &snapshot, sizeof(StatsData));
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /// Copy a consistent snapshot, false if the writer kept it busy for all the attempts
+    bool Read(StatsData &snapshot, int attempts = 1000) const
+    {
+        for (int i = 0; i < attempts; i++)
+        {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+
+            std::memcpy(&snapshot, &data, sizeof(StatsData));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence.load(std::memory_order_relaxed) == before)
+                return true;
+        }
+
+        return false;
+    }
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "The stats sequence must be lock free to be shared between processes");
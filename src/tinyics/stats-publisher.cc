@@ -0,0 +1,226 @@
+#include "stats-publisher.h"
+
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+StatsBlock *StatsPublisher::s_Block = nullptr;
+std::string StatsPublisher::s_Name;
+StatsPublisher::Clock::duration StatsPublisher::s_Period;
+StatsPublisher::Clock::time_point StatsPublisher::s_Start;
+StatsPublisher::Clock::time_point StatsPublisher::s_LastPublish;
+uint64_t StatsPublisher::s_LastEvents = 0;
+bool StatsPublisher::s_Finished = false;
+CallbackStats StatsPublisher::s_PlantTicks;
+CallbackStats StatsPublisher::s_PythonCallbacks;
+std::vector<ns3::Ptr<ScadaApplication>> StatsPublisher::s_Scadas;
+StatsData StatsPublisher::s_Snapshot;
+ns3::EventId StatsPublisher::s_CheckEvent;
+ns3::EventId StatsPublisher::s_FinishEvent;
+
+void
+StatsPublisher::Open(const std::string &name, uint64_t period)
+{
+    if (s_Block)
+        Unmap(name != s_Name);
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd == -1)
+        NS_FATAL_ERROR("Failed to open the stats segment '" << name << "'");
+
+    if (ftruncate(fd, sizeof(StatsBlock)) == -1)
+    {
+        close(fd);
+        NS_FATAL_ERROR("Failed to size the stats segment '" << name << "'");
+    }
+
+    void *addr = mmap(nullptr, sizeof(StatsBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED)
+        NS_FATAL_ERROR("Failed to map the stats segment '" << name << "'");
+
+    s_Block = static_cast<StatsBlock *>(addr);
+    s_Name = name;
+    s_Period = std::chrono::milliseconds(period);
+    s_Start = Clock::now();
+    s_LastPublish = s_Start;
+    s_LastEvents = ns3::Simulator::GetEventCount();
+    s_Finished = false;
+    s_PlantTicks = CallbackStats();
+    s_PythonCallbacks = CallbackStats();
+    s_Snapshot = StatsData();
+
+    // Readers check the magic last, so they never see a half initialized segment
+    s_Block->magic = 0;
+    s_Block->version = STATS_VERSION;
+    s_Block->sequence.store(0, std::memory_order_relaxed);
+    s_Block->Write(s_Snapshot);
+    std::atomic_thread_fence(std::memory_order_release);
+    s_Block->magic = STATS_MAGIC;
+
+    // Reopening replaces the events of the previous segment
+    s_CheckEvent.Cancel();
+    s_FinishEvent.Cancel();
+
+    s_CheckEvent = ns3::Simulator::ScheduleNow(&StatsPublisher::Check);
+    s_FinishEvent = ns3::Simulator::ScheduleDestroy(&StatsPublisher::Finish);
+}
+
+void
+StatsPublisher::Close(bool unlink)
+{
+    if (!s_Block)
+        return;
+
+    Unmap(unlink);
+    s_Scadas.clear();
+}
+
+void
+StatsPublisher::Unmap(bool unlink)
+{
+    munmap(s_Block, sizeof(StatsBlock));
+    s_Block = nullptr;
+
+    if (unlink)
+        shm_unlink(s_Name.c_str());
+}
+
+void
+StatsPublisher::Watch(ns3::Ptr<ScadaApplication> scada)
+{
+    scada->EnableTracing();
+    s_Scadas.push_back(scada);
+}
+
+CallbackStats &
+StatsPublisher::GetPlantTicks()
+{
+    return s_PlantTicks;
+}
+
+CallbackStats &
+StatsPublisher::GetPythonCallbacks()
+{
+    return s_PythonCallbacks;
+}
+
+void
+StatsPublisher::Publish()
+{
+    if (!s_Block)
+        return;
+
+    Clock::time_point now = Clock::now();
+    StatsData &data = s_Snapshot;
+
+    data.finished = s_Finished;
+    data.simulatedTime = ns3::Simulator::Now().GetSeconds();
+    data.wallTime = std::chrono::duration<double>(now - s_Start).count();
+    data.speedup = data.wallTime > 0 ? data.simulatedTime / data.wallTime : 0;
+
+    double elapsed = std::chrono::duration<double>(now - s_LastPublish).count();
+    uint64_t events = ns3::Simulator::GetEventCount();
+    data.eventRate = elapsed > 0 ? (events - s_LastEvents) / elapsed : 0;
+    data.events = events;
+
+    data.plantTicks = s_PlantTicks.calls;
+    data.plantTickLast = s_PlantTicks.last * 1e3;
+    data.plantTickMean = s_PlantTicks.calls ? s_PlantTicks.total * 1e3 / s_PlantTicks.calls : 0;
+    data.plantTickMax = s_PlantTicks.max * 1e3;
+    data.pythonCalls = s_PythonCallbacks.calls;
+    data.pythonTime = s_PythonCallbacks.total;
+
+    data.pendingTransactions = 0;
+    data.rtuCount = 0;
+
+    for (const ns3::Ptr<ScadaApplication> &scada : s_Scadas)
+    {
+        size_t first = data.rtuCount;
+        size_t count = scada->GetRTUCount();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            uint16_t pending = scada->GetPendingTransactions(i);
+            data.pendingTransactions += pending;
+
+            if (first + i >= STATS_MAX_RTUS)
+                continue;
+
+            StatsRtu &rtu = data.rtus[first + i];
+
+            std::ostringstream address;
+            address << scada->GetRTUAddress(i);
+            std::snprintf(rtu.name, STATS_NAME_SZ, "%s/%s:%u", scada->GetName().c_str(),
+                          address.str().c_str(), scada->GetRTUUnitId(i));
+
+            rtu.requests = rtu.responses = rtu.timeouts = 0;
+            rtu.pending = pending;
+            rtu.meanLatency = rtu.p99Latency = rtu.maxLatency = 0;
+        }
+
+        // The tracer keeps the latency per RTU and function code, merge the function codes
+        std::vector<uint64_t> samples(count, 0);
+
+        for (const auto &[key, stats] : scada->GetTracer().GetStats())
+        {
+            if (key.first >= count || first + key.first >= STATS_MAX_RTUS)
+                continue;
+
+            StatsRtu &rtu = data.rtus[first + key.first];
+            uint64_t recorded = stats.latency.GetCount();
+
+            if (recorded > 0)
+            {
+                // Weighted sum for now, divided below
+                rtu.meanLatency += stats.latency.GetMean() / 1e3 * recorded;
+                rtu.p99Latency = std::max(rtu.p99Latency, stats.latency.GetPercentile(99) / 1e3);
+                rtu.maxLatency = std::max(rtu.maxLatency, stats.latency.GetMax() / 1e3);
+                samples[key.first] += recorded;
+            }
+
+            rtu.requests += stats.requests;
+            rtu.responses += stats.responses;
+            rtu.timeouts += stats.timeouts;
+        }
+
+        for (size_t i = 0; i < count && first + i < STATS_MAX_RTUS; i++)
+        {
+            if (samples[i] > 0)
+                data.rtus[first + i].meanLatency /= samples[i];
+        }
+
+        data.rtuCount += count;
+    }
+
+    s_Block->Write(data);
+
+    s_LastPublish = now;
+    s_LastEvents = events;
+}
+
+void
+StatsPublisher::Check()
+{
+    if (!s_Block)
+        return;
+
+    if (Clock::now() - s_LastPublish >= s_Period)
+        Publish();
+
+    s_CheckEvent =
+        ns3::Simulator::Schedule(ns3::MilliSeconds(s_CheckInterval), &StatsPublisher::Check);
+}
+
+void
+StatsPublisher::Finish()
+{
+    s_Finished = true;
+    Publish();
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "ns3/event-id.h"
+
+#include "scada-application.h"
+#include "stats-block.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/// Wall time spent in a kind of callback
+struct CallbackStats
+{
+    uint64_t calls = 0;
+    double total = 0; //!< Seconds
+    double last = 0;  //!< Seconds
+    double max = 0;   //!< Seconds
+
+    inline void Record(double seconds)
+    {
+        calls++;
+        total += seconds;
+        last = seconds;
+        max = seconds > max ? seconds : max;
+    }
+};
+
+/**
+ * Publishes live statistics of the simulation in a POSIX shared memory
+ * segment (see StatsBlock for the layout).
+ *
+ * The simulated and wall clock time, event rate, plant tick duration, time
+ * spent in Python and per RTU poll latency and pending transactions of the
+ * watched SCADAs can be read by other processes (e.g. tinyics-stats) while
+ * the simulation runs, without stopping it.
+ *
+ * The segment is refreshed from the simulator thread at most once per
+ * period of wall clock time, by an event that checks the clock every few
+ * simulated milliseconds. Between refreshes the hot path only adds up the
+ * plant and Python callback times, and only while the segment is open.
+ */
+class StatsPublisher
+{
+public:
+    /**
+     * Create (or reuse) the segment and start publishing, reopening keeps
+     * the watched SCADAs
+     *
+     * \param name name of the segment, e.g. "/tinyics" (/dev/shm/tinyics)
+     * \param period wall clock milliseconds between refreshes
+     */
+    static void Open(const std::string &name = "/tinyics", uint64_t period = 100);
+
+    /**
+     * Stop publishing and forget the watched SCADAs, the segment is removed
+     * unless `unlink` is false
+     */
+    static void Close(bool unlink = true);
+
+    static inline bool IsOpen()
+    {
+        return s_Block != nullptr;
+    }
+
+    /// Report the RTUs of the SCADA, enables its tracing to measure the poll latency
+    static void Watch(ns3::Ptr<ScadaApplication> scada);
+
+    /// Refresh the segment now
+    static void Publish();
+
+    static CallbackStats &GetPlantTicks();
+
+    static CallbackStats &GetPythonCallbacks();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Checks the wall clock every s_CheckInterval and publishes once the period elapsed
+    static void Check();
+
+    /// Publish the final values at Simulator::Destroy
+    static void Finish();
+
+    /// Release the segment, removing it if `unlink` is true
+    static void Unmap(bool unlink);
+
+    static constexpr uint64_t s_CheckInterval = 10; //!< Simulated milliseconds
+
+    static StatsBlock *s_Block;
+    static std::string s_Name;
+    static Clock::duration s_Period;
+    static Clock::time_point s_Start;
+    static Clock::time_point s_LastPublish;
+    static uint64_t s_LastEvents;
+    static bool s_Finished;
+    static CallbackStats s_PlantTicks;
+    static CallbackStats s_PythonCallbacks;
+    static std::vector<ns3::Ptr<ScadaApplication>> s_Scadas;
+    static StatsData s_Snapshot; //!< Built here and copied to the segment in one go
+    static ns3::EventId s_CheckEvent;
+    static ns3::EventId s_FinishEvent;
+};
+
+/**
+ * Adds the wall time of the enclosing scope to the stats while the segment
+ * is open
+ */
+class StatsTimer
+{
+public:
+    explicit StatsTimer(CallbackStats &stats)
+        : m_Stats(StatsPublisher::IsOpen() ? &stats : nullptr)
+    {
+        if (m_Stats)
+            m_Start = std::chrono::steady_clock::now();
+    }
+
+    ~StatsTimer()
+    {
+        if (m_Stats)
+        {
+            auto elapsed = std::chrono::steady_clock::now() - m_Start;
+            m_Stats->Record(std::chrono::duration<double>(elapsed).count());
+        }
+    }
+
+    StatsTimer(const StatsTimer &) = delete;
+    StatsTimer &operator=(const StatsTimer &) = delete;
+
+private:
+    CallbackStats *m_Stats;
+    std::chrono::steady_clock::time_point m_Start;
+};
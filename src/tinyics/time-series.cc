@@ -0,0 +1,365 @@
+#include "time-series.h"
+
+#include "ns3/fatal-error.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+uint64_t
+ToBits(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double
+FromBits(uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int64_t
+SignExtend(uint64_t value, uint8_t n)
+{
+    uint64_t sign = 1ULL << (n - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+/// Reads back what TimeSeries::WriteBits wrote, least significant bits first
+class BitReader
+{
+public:
+    BitReader(const std::vector<uint64_t> &bits)
+        : m_Bits(bits)
+    {
+    }
+
+    uint64_t Read(uint8_t n)
+    {
+        if (n == 0)
+            return 0;
+
+        size_t word = m_Pos / 64;
+        uint8_t offset = m_Pos % 64;
+        m_Pos += n;
+
+        uint64_t value = m_Bits[word] >> offset;
+        if (offset + n > 64)
+            value |= m_Bits[word + 1] << (64 - offset);
+
+        return n == 64 ? value : value & ((1ULL << n) - 1);
+    }
+
+private:
+    const std::vector<uint64_t> &m_Bits;
+    uint64_t m_Pos = 0;
+};
+
+} // namespace
+
+void
+TimeSeries::Append(int64_t time, double value)
+{
+    if (!m_Blocks.empty() && time < m_Blocks.back().end)
+        NS_FATAL_ERROR("Samples must be appended in order, got " << time << " after "
+                                                                 << m_Blocks.back().end);
+
+    m_Count++;
+
+    // Start a new block, its first sample is stored as is
+    if (m_Blocks.empty() || m_Blocks.back().count == s_BlockSize)
+    {
+        Block block;
+        block.start = block.end = time;
+        block.first = block.min = block.max = block.sum = block.last = value;
+        block.count = 1;
+
+        m_Blocks.push_back(std::move(block));
+        m_Encoder = Encoder();
+        m_Encoder.value = ToBits(value);
+        return;
+    }
+
+    Block &block = m_Blocks.back();
+
+    AppendTime(block, time);
+    AppendValue(block, value);
+
+    block.min = std::min(block.min, value);
+    block.max = std::max(block.max, value);
+    block.sum += value;
+    block.last = value;
+
+    // Full, it won't grow anymore
+    if (++block.count == s_BlockSize)
+    {
+        block.bits.shrink_to_fit();
+        m_Memory += sizeof(Block) + block.bits.capacity() * sizeof(uint64_t);
+    }
+}
+
+void
+TimeSeries::AppendTime(Block &block, int64_t time)
+{
+    int64_t delta = time - block.end;
+    int64_t dod = delta - m_Encoder.delta;
+
+    // Control bits are written first to last: '0', '10', '110', '1110' and '1111'
+    if (dod == 0)
+    {
+        WriteBits(block, 0, 1);
+    }
+    else if (dod >= -64 && dod <= 63)
+    {
+        WriteBits(block, 0b01, 2);
+        WriteBits(block, dod, 7);
+    }
+    else if (dod >= -256 && dod <= 255)
+    {
+        WriteBits(block, 0b011, 3);
+        WriteBits(block, dod, 9);
+    }
+    else if (dod >= -2048 && dod <= 2047)
+    {
+        WriteBits(block, 0b0111, 4);
+        WriteBits(block, dod, 12);
+    }
+    else
+    {
+        WriteBits(block, 0b1111, 4);
+        WriteBits(block, dod, 64);
+    }
+
+    block.end = time;
+    m_Encoder.delta = delta;
+}
+
+void
+TimeSeries::AppendValue(Block &block, double value)
+{
+    uint64_t bits = ToBits(value);
+    uint64_t x = bits ^ m_Encoder.value;
+    m_Encoder.value = bits;
+
+    // Same value
+    if (x == 0)
+    {
+        WriteBits(block, 0, 1);
+        return;
+    }
+
+    // Leading zeros are stored in 5 bits
+    uint8_t leading = std::min(__builtin_clzll(x), 31);
+    uint8_t trailing = __builtin_ctzll(x);
+
+    // The meaningful bits fit in the window of the previous XOR
+    if (m_Encoder.leading != 0xFF && leading >= m_Encoder.leading &&
+        trailing >= m_Encoder.trailing)
+    {
+        WriteBits(block, 0b01, 2);
+        WriteBits(block, x >> m_Encoder.trailing, 64 - m_Encoder.leading - m_Encoder.trailing);
+        return;
+    }
+
+    uint8_t meaningful = 64 - leading - trailing;
+
+    WriteBits(block, 0b11, 2);
+    WriteBits(block, leading, 5);
+    WriteBits(block, meaningful - 1, 6);
+    WriteBits(block, x >> trailing, meaningful);
+
+    m_Encoder.leading = leading;
+    m_Encoder.trailing = trailing;
+}
+
+void
+TimeSeries::WriteBits(Block &block, uint64_t value, uint8_t n)
+{
+    if (n < 64)
+        value &= (1ULL << n) - 1;
+
+    size_t word = block.size / 64;
+    uint8_t offset = block.size % 64;
+    block.size += n;
+
+    if (word == block.bits.size())
+        block.bits.push_back(0);
+
+    block.bits[word] |= value << offset;
+
+    if (offset + n > 64)
+        block.bits.push_back(value >> (64 - offset));
+}
+
+template <typename F>
+void
+TimeSeries::Decode(const Block &block, F f)
+{
+    BitReader reader(block.bits);
+
+    int64_t time = block.start;
+    int64_t delta = 0;
+    uint64_t value = ToBits(block.first);
+    uint8_t leading = 0;
+    uint8_t trailing = 0;
+
+    f(time, block.first);
+
+    for (uint16_t i = 1; i < block.count; i++)
+    {
+        int64_t dod;
+
+        if (!reader.Read(1))
+            dod = 0;
+        else if (!reader.Read(1))
+            dod = SignExtend(reader.Read(7), 7);
+        else if (!reader.Read(1))
+            dod = SignExtend(reader.Read(9), 9);
+        else if (!reader.Read(1))
+            dod = SignExtend(reader.Read(12), 12);
+        else
+            dod = static_cast<int64_t>(reader.Read(64));
+
+        delta += dod;
+        time += delta;
+
+        if (reader.Read(1))
+        {
+            // New window
+            if (reader.Read(1))
+            {
+                leading = reader.Read(5);
+                trailing = 64 - leading - (reader.Read(6) + 1);
+            }
+
+            value ^= reader.Read(64 - leading - trailing) << trailing;
+        }
+
+        f(time, FromBits(value));
+    }
+}
+
+std::vector<TimeSample>
+TimeSeries::Query(int64_t from, int64_t to) const
+{
+    std::vector<TimeSample> samples;
+
+    for (const Block &block : m_Blocks)
+    {
+        if (block.start > to)
+            break;
+
+        if (block.end < from)
+            continue;
+
+        Decode(block, [&](int64_t time, double value) {
+            if (time >= from && time <= to)
+                samples.push_back({time / 1e6, value});
+        });
+    }
+
+    return samples;
+}
+
+std::vector<TimeBucket>
+TimeSeries::Downsample(int64_t from, int64_t to, int64_t step) const
+{
+    if (step <= 0)
+        NS_FATAL_ERROR("The downsampling step must be greater than zero");
+
+    std::vector<TimeBucket> buckets;
+    int64_t current = -1; // Index of the last bucket
+
+    // The mean holds the sum until the end
+    auto add = [&](int64_t time, uint64_t count, double min, double max, double sum, double last) {
+        int64_t idx = (time - from) / step;
+
+        if (idx != current)
+        {
+            buckets.push_back({(from + idx * step) / 1e6, 0, min, max, 0, last});
+            current = idx;
+        }
+
+        TimeBucket &bucket = buckets.back();
+        bucket.count += count;
+        bucket.min = std::min(bucket.min, min);
+        bucket.max = std::max(bucket.max, max);
+        bucket.mean += sum;
+        bucket.last = last;
+    };
+
+    for (const Block &block : m_Blocks)
+    {
+        if (block.start >= to)
+            break;
+
+        if (block.end < from)
+            continue;
+
+        // The whole block falls in a single bucket, no need to decode it
+        if (block.start >= from && block.end < to &&
+            (block.start - from) / step == (block.end - from) / step)
+        {
+            add(block.start, block.count, block.min, block.max, block.sum, block.last);
+            continue;
+        }
+
+        Decode(block, [&](int64_t time, double value) {
+            if (time >= from && time < to)
+                add(time, 1, value, value, value, value);
+        });
+    }
+
+    for (TimeBucket &bucket : buckets)
+        bucket.mean /= bucket.count;
+
+    return buckets;
+}
+
+void
+TimeSeries::DropBefore(int64_t time)
+{
+    // Only full blocks are dropped, the open one holds the encoder state
+    while (!m_Blocks.empty() && m_Blocks.front().end < time &&
+           m_Blocks.front().count == s_BlockSize)
+        DropOldest();
+}
+
+void
+TimeSeries::Trim(size_t bytes)
+{
+    while (!m_Blocks.empty() && GetMemoryUsage() > bytes && m_Blocks.front().count == s_BlockSize)
+        DropOldest();
+}
+
+void
+TimeSeries::DropOldest()
+{
+    const Block &block = m_Blocks.front();
+    m_Memory -= sizeof(Block) + block.bits.capacity() * sizeof(uint64_t);
+    m_Count -= block.count;
+    m_Blocks.pop_front();
+}
+
+uint64_t
+TimeSeries::GetCount() const
+{
+    return m_Count;
+}
+
+size_t
+TimeSeries::GetMemoryUsage() const
+{
+    size_t memory = m_Memory;
+
+    if (!m_Blocks.empty() && m_Blocks.back().count < s_BlockSize)
+        memory += sizeof(Block) + m_Blocks.back().bits.capacity() * sizeof(uint64_t);
+
+    return memory;
+}
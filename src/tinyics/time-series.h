@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/// A value recorded at the given time (in seconds)
+struct TimeSample
+{
+    double time;
+    double value;
+};
+
+/// Aggregate of the samples that fall in [start, start + step)
+struct TimeBucket
+{
+    double start;
+    uint64_t count;
+    double min;
+    double max;
+    double mean;
+    double last;
+};
+
+/**
+ * Compressed series of samples, in the style of Facebook's Gorilla.
+ *
+ * Samples are kept in blocks of up to s_BlockSize samples. The first
+ * sample of a block is stored as is, the rest as bit packed:
+ *
+ *  - Timestamps (microseconds) by their delta-of-delta, a single bit when
+ *    sampled at a regular rate and 9 to 68 bits when the rate changes.
+ *  - Values by their XOR with the previous one, a single bit when the value
+ *    didn't change and only the meaningful bits of the XOR otherwise.
+ *
+ * Polled process values take a few bits per sample. Each block also keeps
+ * its time span, minimum, maximum and sum, so queries skip the blocks out
+ * of range without decoding them and downsampling uses them directly when
+ * a whole block falls in one bucket.
+ *
+ * Memory is bounded by dropping the oldest blocks, either past a retention
+ * window (DropBefore) or above a byte budget (Trim).
+ */
+class TimeSeries
+{
+public:
+    /// Record a sample, the time (in microseconds) must not go backwards
+    void Append(int64_t time, double value);
+
+    /// Samples within [from, to] (in microseconds)
+    std::vector<TimeSample> Query(int64_t from, int64_t to) const;
+
+    /// Aggregates of the samples within [from, to) in buckets of `step` microseconds
+    std::vector<TimeBucket> Downsample(int64_t from, int64_t to, int64_t step) const;
+
+    /// Drop the blocks whose samples are all older than `time`
+    void DropBefore(int64_t time);
+
+    /// Drop the oldest blocks until the series takes at most `bytes` (the open block is kept)
+    void Trim(size_t bytes);
+
+    uint64_t GetCount() const;
+
+    /// Bytes taken by the blocks of the series
+    size_t GetMemoryUsage() const;
+
+private:
+    static constexpr uint16_t s_BlockSize = 1024;
+
+    struct Block
+    {
+        int64_t start; //!< Time of the first sample
+        int64_t end;   //!< Time of the last sample
+        double first;  //!< Value of the first sample
+        double min;
+        double max;
+        double sum;
+        double last;
+        uint16_t count = 0;
+        uint64_t size = 0;          //!< Bits written
+        std::vector<uint64_t> bits; //!< Every sample but the first
+    };
+
+    /// Encoding state of the open (last) block
+    struct Encoder
+    {
+        int64_t delta = 0;
+        uint64_t value = 0;
+        uint8_t leading = 0xFF; //!< Leading zeros of the previous XOR window (0xFF for none)
+        uint8_t trailing = 0;
+    };
+
+    /// Call `f(time, value)` for every sample of the block
+    template <typename F>
+    static void Decode(const Block &block, F f);
+
+    static void WriteBits(Block &block, uint64_t value, uint8_t n);
+
+    void AppendTime(Block &block, int64_t time);
+
+    void AppendValue(Block &block, double value);
+
+    /// Drop the first block, which must be full
+    void DropOldest();
+
+    std::deque<Block> m_Blocks;
+    Encoder m_Encoder;
+    uint64_t m_Count = 0;
+    size_t m_Memory = 0; //!< Bytes taken by the closed blocks
+};
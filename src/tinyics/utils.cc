@@ -2,8 +2,6 @@
 
 #include <ns3/fatal-error.h>
 
-#include <limits>
-
 std::tuple<uint8_t, uint8_t>
 SplitUint16(uint16_t value)
 {
@@ -69,9 +67,9 @@ NormalizeInRange(double value, double min, double max)
 }
 
 double
-DenormalizeU16InRange(uint16_t value, double min, double max)
+DenormalizeU16InRange(uint16_t value, double min, double max, uint16_t fullScale)
 {
-    double scalingFactor = (max - min) / std::numeric_limits<uint16_t>::max();
+    double scalingFactor = (max - min) / fullScale;
 
     return scalingFactor * value;
 }
@@ -2,6 +2,7 @@
 
 #include <tuple>
 #include <cstdint>
+#include <limits>
 
 /*
  * Take an uint16_t and return the higher and lower parts of the split
@@ -41,6 +42,12 @@ double NormalizeInRange(double value, double min, double max);
 
 /*
  * For a given uint16_t value scale it to the range [min, max]
+ *
+ * `fullScale` is the largest value of the register, lower it to match
+ * PLCs with a reduced ADC resolution (see PlcState::GetAnalogFullScale)
  */
-double DenormalizeU16InRange(uint16_t value, double min, double max);
+double DenormalizeU16InRange(uint16_t value,
+                             double min,
+                             double max,
+                             uint16_t fullScale = std::numeric_limits<uint16_t>::max());
 
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "modbus.h"
+#include "modbus-traits.h"
 
 #include "ns3/fatal-error.h"
 
 #include <cstdint>
+#include <cstdlib>
 
 enum VarType
 {
@@ -13,15 +15,18 @@ enum VarType
     InputRegister,
 };
 
+static_assert(static_cast<int>(MB_Image::Coils) == VarType::Coil &&
+                  static_cast<int>(MB_Image::DiscreteInputs) == VarType::DigitalInput &&
+                  static_cast<int>(MB_Image::InputRegisters) == VarType::InputRegister,
+              "VarType should follow the order of MB_Image");
+
 // TODO: Add operator overloading.
 class Var
 {
 public:
-    Var(VarType type, uint8_t pos, uint8_t uid)
-        : m_Type(type), m_Pos(pos), m_Value(0), m_UID(uid)
+    Var(VarType type, uint8_t pos, uint32_t rtu)
+        : m_Type(type), m_Pos(pos), m_Value(0), m_RTU(rtu)
     {
-        if (uid == 0)
-            NS_FATAL_ERROR("Unit Id cannot be 0 for RTU");
     }
 
     VarType GetType() const { return m_Type; }
@@ -30,10 +35,39 @@ public:
 
     uint8_t GetPosition() const { return m_Pos; }
 
-    uint8_t GetUID() const { return m_UID; }
+    /*
+     * Get the handle of the RTU the variable is read from
+     */
+    uint32_t GetRTU() const { return m_RTU; }
 
     void SetValue(uint16_t val) {
         m_Value = (m_Type == VarType::Coil) ? val > 0 : val;
+
+        // Only flag the change once the value moved further than the deadband
+        // from the last reported one. The first value is always reported.
+        int32_t delta = std::abs(static_cast<int32_t>(m_Value) - m_Reported);
+        m_Dirty = m_Reported < 0 || delta > m_Deadband;
+    }
+
+    /*
+     * Set the minimum change (in raw units) needed to report a new value
+     */
+    void SetDeadband(uint16_t deadband) { m_Deadband = deadband; }
+
+    uint16_t GetDeadband() const { return m_Deadband; }
+
+    /*
+     * Whether the value changed since it was last reported
+     */
+    bool IsDirty() const { return m_Dirty; }
+
+    /*
+     * Mark the current value as reported
+     */
+    void ClearDirty()
+    {
+        m_Reported = m_Value;
+        m_Dirty = false;
     }
 
     /*
@@ -41,37 +75,36 @@ public:
      */
     static MB_FunctionCode IntoFCRead(VarType type)
     {
-        switch (type)
-        {
-            case VarType::Coil:
-                return MB_FunctionCode::ReadCoils;
-            case VarType::DigitalInput:
-                return MB_FunctionCode::ReadDiscreteInputs;
-            case VarType::InputRegister:
-                return MB_FunctionCode::ReadInputRegisters;
-        }
+        static constexpr MB_FunctionCode s_Reads[] = {
+            MB_FunctionCode::ReadCoils,
+            MB_FunctionCode::ReadDiscreteInputs,
+            MB_FunctionCode::ReadInputRegisters,
+        };
+
+        return s_Reads[type];
     }
 
+    /*
+     * Get the variable type of the image targeted by the function code
+     */
     static VarType IntoVarType(MB_FunctionCode fc)
     {
-        switch (fc)
-        {
-            case MB_FunctionCode::ReadCoils:
-            case MB_FunctionCode::WriteSingleCoil:
-                return VarType::Coil;
-            case MB_FunctionCode::ReadDiscreteInputs:
-                return VarType::DigitalInput;
-            case MB_FunctionCode::ReadInputRegisters:
-                return VarType::InputRegister;
-            default:
-                NS_FATAL_ERROR("Could not convert '" << (int)fc << "' function code into VarType");
-        }
+        MB_Image image = GetFunctionTraits(fc).image;
+
+        if (image == MB_Image::None)
+            NS_FATAL_ERROR("Could not convert '" << (int)fc << "' function code into VarType");
+
+        // VarType follows the order of the images
+        return static_cast<VarType>(image);
     }
     
 private:
     VarType m_Type;
     uint16_t m_Value;
     uint8_t m_Pos;
-    uint8_t m_UID;
+    uint32_t m_RTU;
+    uint16_t m_Deadband = 0;    //!< Minimum change to report
+    int32_t m_Reported = -1;    //!< Last value reported (-1 if never reported)
+    bool m_Dirty = false;       //!< Value changed since last reported
 };
 
@@ -0,0 +1,91 @@
+#include "bit-packing.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+
+/// Bit at a time reference of CopyBits
+void
+ReferenceCopyBits(const uint8_t *src,
+                  uint32_t srcOffset,
+                  uint8_t *dst,
+                  uint32_t dstOffset,
+                  uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t pos = dstOffset + i;
+        uint8_t mask = 1 << (pos & 7);
+
+        if (GetPackedBit(src, srcOffset + i))
+            dst[pos >> 3] |= mask;
+        else
+            dst[pos >> 3] &= ~mask;
+    }
+}
+
+std::vector<uint8_t>
+MakePattern(size_t size, uint8_t seed)
+{
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; i++)
+        bytes[i] = static_cast<uint8_t>(i * 73 + seed);
+
+    return bytes;
+}
+
+} // namespace
+
+TEST(CopyBits, MatchesReferenceForEveryAlignment)
+{
+    std::vector<uint8_t> src = MakePattern(40, 5);
+
+    // Offsets on both sides of a byte, counts around the 56 bit step
+    for (uint32_t srcOffset = 0; srcOffset < 16; srcOffset++)
+    {
+        for (uint32_t dstOffset = 0; dstOffset < 16; dstOffset++)
+        {
+            for (uint32_t count : {0u, 1u, 7u, 8u, 9u, 55u, 56u, 57u, 64u, 120u, 200u})
+            {
+                std::vector<uint8_t> expected = MakePattern(40, 200);
+                std::vector<uint8_t> actual = expected;
+
+                ReferenceCopyBits(src.data(), srcOffset, expected.data(), dstOffset, count);
+                CopyBits(src.data(), srcOffset, actual.data(), dstOffset, count);
+
+                ASSERT_EQ(actual, expected) << "src offset " << srcOffset << ", dst offset "
+                                            << dstOffset << ", count " << count;
+            }
+        }
+    }
+}
+
+TEST(CopyBits, LeavesBitsOutsideTheRangeUntouched)
+{
+    const uint8_t src[4] = {};
+    uint8_t dst[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+
+    CopyBits(src, 0, dst, 3, 10);
+
+    EXPECT_EQ(dst[0], 0x07);
+    EXPECT_EQ(dst[1], 0xE0);
+    EXPECT_EQ(dst[2], 0xFF);
+    EXPECT_EQ(dst[3], 0xFF);
+}
+
+TEST(CopyBits, RoundTrip)
+{
+    std::vector<uint8_t> coils = MakePattern(PackedSize(2000), 9);
+    std::vector<uint8_t> packed(PackedSize(2000) + 1);
+    std::vector<uint8_t> unpacked(coils.size());
+
+    // Out to an unaligned buffer and back, like a read of coils 13-1012
+    CopyBits(coils.data(), 13, packed.data(), 5, 1000);
+    CopyBits(packed.data(), 5, unpacked.data(), 13, 1000);
+
+    for (uint32_t i = 13; i < 1013; i++)
+        ASSERT_EQ(GetPackedBit(unpacked.data(), i), GetPackedBit(coils.data(), i)) << i;
+}
@@ -0,0 +1,66 @@
+#include "modbus-rtu.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+/// Bit at a time reference of the CRC, straight from the specification
+uint16_t
+ReferenceCRC16(const uint8_t *data, uint32_t size)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+
+    return crc;
+}
+
+} // namespace
+
+TEST(ModbusCRC16, KnownVectors)
+{
+    // Read 10 holding registers from slave 1, the CRC goes on the wire as C5 CD
+    const uint8_t request[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x0A};
+    EXPECT_EQ(ModbusCRC16(request, sizeof(request)), 0xCDC5);
+
+    // Check value of CRC-16/MODBUS
+    const char *check = "123456789";
+    EXPECT_EQ(ModbusCRC16(reinterpret_cast<const uint8_t *>(check), strlen(check)), 0x4B37);
+
+    EXPECT_EQ(ModbusCRC16(nullptr, 0), 0xFFFF);
+}
+
+TEST(ModbusCRC16, MatchesReference)
+{
+    std::vector<uint8_t> data(RTU_MAX_SZ);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = static_cast<uint8_t>(i * 37 + 11);
+
+    for (uint32_t size = 0; size <= data.size(); size++)
+        EXPECT_EQ(ModbusCRC16(data.data(), size), ReferenceCRC16(data.data(), size)) << size;
+}
+
+TEST(ModbusCRC16, FrameWithItsCrcChecksToZero)
+{
+    std::vector<uint8_t> frame = {0x11, 0x05, 0x00, 0xAC, 0xFF, 0x00};
+    uint16_t crc = ModbusCRC16(frame.data(), frame.size());
+
+    // Low byte first, as the frames carry it
+    frame.push_back(crc & 0xFF);
+    frame.push_back(crc >> 8);
+
+    EXPECT_EQ(ModbusCRC16(frame.data(), frame.size()), 0);
+
+    frame[2] ^= 0x10;
+    EXPECT_NE(ModbusCRC16(frame.data(), frame.size()), 0);
+}
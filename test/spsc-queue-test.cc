@@ -0,0 +1,93 @@
+#include "spsc-queue.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+TEST(SpscQueue, CapacityIsRoundedToAPowerOfTwo)
+{
+    EXPECT_EQ(SpscQueue<int>(0).GetCapacity(), 2u);
+    EXPECT_EQ(SpscQueue<int>(2).GetCapacity(), 2u);
+    EXPECT_EQ(SpscQueue<int>(3).GetCapacity(), 4u);
+    EXPECT_EQ(SpscQueue<int>(1000).GetCapacity(), 1024u);
+}
+
+TEST(SpscQueue, FullAndEmpty)
+{
+    SpscQueue<int> queue(4);
+    int item;
+
+    EXPECT_FALSE(queue.Pop(item));
+
+    for (int i = 0; i < 4; i++)
+        EXPECT_TRUE(queue.Push(i));
+
+    EXPECT_FALSE(queue.Push(4));
+    EXPECT_EQ(queue.GetSize(), 4u);
+
+    EXPECT_TRUE(queue.Pop(item));
+    EXPECT_EQ(item, 0);
+    EXPECT_TRUE(queue.Push(4));
+}
+
+TEST(SpscQueue, KeepsOrderAcrossWrapAround)
+{
+    SpscQueue<int> queue(8);
+    int next = 0;
+    int expected = 0;
+
+    // Push and pop in uneven amounts so the indices wrap many times
+    for (int round = 0; round < 100; round++)
+    {
+        for (int i = 0; i < 5; i++)
+            ASSERT_TRUE(queue.Push(next++));
+
+        int item;
+        for (int i = 0; i < 5; i++)
+        {
+            ASSERT_TRUE(queue.Pop(item));
+            ASSERT_EQ(item, expected++);
+        }
+    }
+
+    EXPECT_EQ(queue.GetSize(), 0u);
+}
+
+TEST(SpscQueue, ProducerAndConsumerThreads)
+{
+    constexpr uint64_t count = 1000000;
+    SpscQueue<uint64_t> queue(64);
+
+    std::thread producer([&queue]() {
+        for (uint64_t i = 0; i < count;)
+        {
+            if (queue.Push(i))
+                i++;
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    // Keep draining on a mismatch, so the producer can finish
+    uint64_t popped = 0;
+    uint64_t outOfOrder = 0;
+    uint64_t item;
+
+    while (popped < count)
+    {
+        if (!queue.Pop(item))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        outOfOrder += item != popped;
+        popped++;
+    }
+
+    producer.join();
+
+    EXPECT_EQ(outOfOrder, 0u);
+    EXPECT_FALSE(queue.Pop(item));
+}
@@ -0,0 +1,166 @@
+#include "time-series.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+uint64_t
+ToBits(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/// Append the samples and check that they are all read back bit for bit
+void
+ExpectRoundTrip(const std::vector<TimeSample> &samples)
+{
+    TimeSeries series;
+    for (const TimeSample &sample : samples)
+        series.Append(static_cast<int64_t>(sample.time), sample.value);
+
+    ASSERT_EQ(series.GetCount(), samples.size());
+
+    std::vector<TimeSample> decoded = series.Query(std::numeric_limits<int64_t>::min(),
+                                                   std::numeric_limits<int64_t>::max());
+    ASSERT_EQ(decoded.size(), samples.size());
+
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        // Query reports the time in seconds
+        ASSERT_EQ(static_cast<int64_t>(std::llround(decoded[i].time * 1e6)),
+                  static_cast<int64_t>(samples[i].time))
+            << "sample " << i;
+        ASSERT_EQ(ToBits(decoded[i].value), ToBits(samples[i].value)) << "sample " << i;
+    }
+}
+
+} // namespace
+
+TEST(TimeSeries, RegularRateAndConstantValue)
+{
+    std::vector<TimeSample> samples;
+    for (int i = 0; i < 3000; i++)
+        samples.push_back({i * 500000.0, 4.5});
+
+    ExpectRoundTrip(samples);
+}
+
+TEST(TimeSeries, DeltaOfDeltaEscapesTo64Bits)
+{
+    // Jumps past the 12 bit range in both directions, up to hours of silence
+    std::vector<int64_t> times = {0, 1, 2, 3000, 3001, 3002, 7200000000, 7200000001,
+                                  7200000002, 7200002049, 7200004096, 7200004097};
+
+    std::vector<TimeSample> samples;
+    for (size_t i = 0; i < times.size(); i++)
+        samples.push_back({static_cast<double>(times[i]), static_cast<double>(i)});
+
+    ExpectRoundTrip(samples);
+}
+
+TEST(TimeSeries, EveryTimestampBucket)
+{
+    // Delta-of-deltas at both ends of each encoded range
+    std::vector<int64_t> dods = {0, -64, 63, -65, 64, -256, 255,
+                                 -257, 256, -2048, 2047, -2049, 2048};
+
+    std::vector<TimeSample> samples;
+    int64_t time = 0;
+    int64_t delta = 10000;
+
+    samples.push_back({0, 0});
+    for (int64_t dod : dods)
+    {
+        delta += dod;
+        time += delta;
+        samples.push_back({static_cast<double>(time), 1});
+    }
+
+    ExpectRoundTrip(samples);
+}
+
+TEST(TimeSeries, WritesStraddlingWords)
+{
+    // Random values need most of their bits, so writes keep crossing word boundaries
+    std::mt19937_64 random(42);
+    std::vector<TimeSample> samples;
+    int64_t time = 0;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        time += 1 + random() % 5000;
+
+        uint64_t bits = random();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+
+        // NaNs round trip too, but aren't equal to themselves
+        if (std::isnan(value))
+            value = static_cast<double>(bits >> 11);
+
+        samples.push_back({static_cast<double>(time), value});
+    }
+
+    ExpectRoundTrip(samples);
+}
+
+TEST(TimeSeries, ReusesTheXorWindow)
+{
+    // The XOR of each value with the previous one fits the window of the first
+    // change, then a value with a wider XOR opens a new window
+    std::vector<double> values = {1.0, 1.5, 1.25, 1.75, 1.5, 1.5, 1.125, -1e300, 3.0, 3.0000001,
+                                  3.0000002, 0.0, -0.0, std::numeric_limits<double>::infinity()};
+
+    std::vector<TimeSample> samples;
+    for (size_t i = 0; i < values.size(); i++)
+        samples.push_back({i * 1000.0, values[i]});
+
+    ExpectRoundTrip(samples);
+}
+
+TEST(TimeSeries, QueryAndDownsampleAcrossBlocks)
+{
+    TimeSeries series;
+    for (int64_t i = 0; i < 4000; i++)
+        series.Append(i * 1000, static_cast<double>(i % 10));
+
+    std::vector<TimeSample> samples = series.Query(1000000, 1999000);
+    ASSERT_EQ(samples.size(), 1000u);
+    EXPECT_DOUBLE_EQ(samples.front().time, 1.0);
+    EXPECT_DOUBLE_EQ(samples.back().value, 9.0);
+
+    std::vector<TimeBucket> buckets = series.Downsample(0, 4000000, 1000000);
+    ASSERT_EQ(buckets.size(), 4u);
+
+    for (const TimeBucket &bucket : buckets)
+    {
+        EXPECT_EQ(bucket.count, 1000u);
+        EXPECT_DOUBLE_EQ(bucket.min, 0);
+        EXPECT_DOUBLE_EQ(bucket.max, 9);
+        EXPECT_DOUBLE_EQ(bucket.mean, 4.5);
+    }
+}
+
+TEST(TimeSeries, DropBeforeKeepsTheRecentSamples)
+{
+    TimeSeries series;
+    for (int64_t i = 0; i < 4000; i++)
+        series.Append(i * 1000, static_cast<double>(i));
+
+    series.DropBefore(2048000);
+
+    // Only whole blocks are dropped
+    std::vector<TimeSample> samples = series.Query(0, 4000000);
+    ASSERT_FALSE(samples.empty());
+    EXPECT_LE(samples.front().time, 2.048);
+    EXPECT_DOUBLE_EQ(samples.back().value, 3999);
+}
@@ -0,0 +1,44 @@
+/**
+ * Run a simulation described by a scenario file, without Python.
+ *
+ * Usage: tinyics-run <scenario.json> [duration]
+ *
+ * The duration (in simulated seconds) overrides the one of the scenario.
+ * When the run finishes the run metrics are printed to stderr.
+ */
+
+#include "scenario.h"
+#include "simulation-runner.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+int
+main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <scenario.json> [duration]\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::unique_ptr<Scenario> scenario = Scenario::Load(argv[1]);
+
+    std::chrono::duration<double> setup = std::chrono::steady_clock::now() - start;
+    std::clog << "Loaded " << scenario->GetPlcs().size() << " PLCs and "
+              << scenario->GetScadas().size() << " SCADAs in " << setup.count() << "s\n";
+
+    scenario->GetBuildProfile().Print(std::clog);
+
+    if (argc == 3)
+        SimulationRunner::Run(std::atof(argv[2]));
+    else
+        scenario->Run();
+
+    RunMetrics metrics = SimulationRunner::GetMetrics();
+    std::clog << "Simulated " << metrics.simulatedTime << "s in " << metrics.wallTime << "s ("
+              << metrics.speedup << "x), " << metrics.events << " events\n";
+}
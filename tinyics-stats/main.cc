@@ -0,0 +1,258 @@
+/**
+ * Watch the statistics published by a running simulation.
+ *
+ * Usage: tinyics-stats [-i interval] [-p metrics.prom] [-1] [name]
+ *
+ * Maps the shared memory segment (by default "/tinyics", see
+ * StatsPublisher) and renders it every interval milliseconds (1000 by
+ * default) until the simulation finishes. With -p the values are also
+ * written to the file in the Prometheus text format, to be picked up by the
+ * node exporter's textfile collector. With -1 it prints once and exits.
+ */
+
+#include "stats-block.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+
+/// Map the segment, null if it doesn't exist (yet)
+const StatsBlock *
+MapSegment(const std::string &name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+        return nullptr;
+
+    // The publisher creates the segment before sizing it, reading a page
+    // past the end of the object would raise SIGBUS
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < static_cast<off_t>(sizeof(StatsBlock)))
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    void *addr = mmap(nullptr, sizeof(StatsBlock), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return addr == MAP_FAILED ? nullptr : static_cast<const StatsBlock *>(addr);
+}
+
+void
+Render(const StatsData &data)
+{
+    // Clear the terminal
+    std::printf("\033[H\033[2J");
+
+    std::printf("simulated %10.2fs   wall %10.2fs   speedup %8.2fx%s\n", data.simulatedTime,
+                data.wallTime, data.speedup, data.finished ? "   (finished)" : "");
+    std::printf("events    %10llu   rate %12.0f/s\n", (unsigned long long)data.events,
+                data.eventRate);
+    std::printf("plant     %10llu ticks   last %8.3fms   mean %8.3fms   max %8.3fms\n",
+                (unsigned long long)data.plantTicks, data.plantTickLast, data.plantTickMean,
+                data.plantTickMax);
+    std::printf("python    %10llu calls   %8.3fs\n", (unsigned long long)data.pythonCalls,
+                data.pythonTime);
+    std::printf("pending   %10llu transactions\n\n", (unsigned long long)data.pendingTransactions);
+
+    if (data.rtuCount == 0)
+        return;
+
+    std::printf("%-40s %10s %10s %8s %8s %10s %10s %10s\n", "rtu", "requests", "responses",
+                "timeouts", "pending", "mean ms", "p99 ms", "max ms");
+
+    for (uint32_t i = 0; i < data.rtuCount && i < STATS_MAX_RTUS; i++)
+    {
+        const StatsRtu &rtu = data.rtus[i];
+        std::printf("%-40s %10llu %10llu %8llu %8u %10.3f %10.3f %10.3f\n", rtu.name,
+                    (unsigned long long)rtu.requests, (unsigned long long)rtu.responses,
+                    (unsigned long long)rtu.timeouts, rtu.pending, rtu.meanLatency,
+                    rtu.p99Latency, rtu.maxLatency);
+    }
+
+    if (data.rtuCount > STATS_MAX_RTUS)
+        std::printf("... and %u more\n", data.rtuCount - STATS_MAX_RTUS);
+}
+
+void
+WriteMetric(std::ostream &os, const char *name, const char *type, const char *help, double value)
+{
+    os << "# HELP " << name << ' ' << help << '\n'
+       << "# TYPE " << name << ' ' << type << '\n'
+       << name << ' ' << value << '\n';
+}
+
+/// Write a metric with one sample per RTU, labeled by the RTU
+template <typename F>
+void
+WriteRtuMetric(std::ostream &os,
+               const char *name,
+               const char *type,
+               const char *help,
+               const StatsData &data,
+               F value)
+{
+    os << "# HELP " << name << ' ' << help << '\n' << "# TYPE " << name << ' ' << type << '\n';
+
+    for (uint32_t i = 0; i < data.rtuCount && i < STATS_MAX_RTUS; i++)
+        os << name << "{rtu=\"" << data.rtus[i].name << "\"} " << value(data.rtus[i]) << '\n';
+}
+
+/// Write the metrics in the Prometheus text format, replacing the file atomically
+void
+WritePrometheus(const std::string &path, const StatsData &data)
+{
+    std::string tmp = path + ".tmp";
+    std::ofstream os(tmp);
+    if (!os)
+    {
+        std::cerr << "Failed to write '" << tmp << "'\n";
+        return;
+    }
+
+    // Keep the counters exact
+    os.precision(15);
+
+    WriteMetric(os, "tinyics_simulated_seconds", "gauge", "Simulated seconds elapsed",
+                data.simulatedTime);
+    WriteMetric(os, "tinyics_wall_seconds", "gauge", "Wall clock seconds elapsed", data.wallTime);
+    WriteMetric(os, "tinyics_speedup", "gauge", "Simulated seconds per wall clock second",
+                data.speedup);
+    WriteMetric(os, "tinyics_events_total", "counter", "Simulator events executed", data.events);
+    WriteMetric(os, "tinyics_event_rate", "gauge", "Simulator events per second", data.eventRate);
+    WriteMetric(os, "tinyics_plant_ticks_total", "counter", "Plant updates", data.plantTicks);
+    WriteMetric(os, "tinyics_plant_tick_mean_ms", "gauge", "Mean plant update duration",
+                data.plantTickMean);
+    WriteMetric(os, "tinyics_plant_tick_max_ms", "gauge", "Longest plant update",
+                data.plantTickMax);
+    WriteMetric(os, "tinyics_python_calls_total", "counter", "Calls to Python overrides",
+                data.pythonCalls);
+    WriteMetric(os, "tinyics_python_seconds_total", "counter", "Wall time spent in Python",
+                data.pythonTime);
+    WriteMetric(os, "tinyics_pending_transactions", "gauge", "Modbus transactions pending",
+                data.pendingTransactions);
+
+    WriteRtuMetric(os, "tinyics_rtu_requests_total", "counter", "Requests sent to the RTU", data,
+                   [](const StatsRtu &rtu) { return double(rtu.requests); });
+    WriteRtuMetric(os, "tinyics_rtu_responses_total", "counter", "Responses received from the RTU",
+                   data, [](const StatsRtu &rtu) { return double(rtu.responses); });
+    WriteRtuMetric(os, "tinyics_rtu_timeouts_total", "counter", "Requests to the RTU timed out",
+                   data, [](const StatsRtu &rtu) { return double(rtu.timeouts); });
+    WriteRtuMetric(os, "tinyics_rtu_pending", "gauge", "Transactions to the RTU pending", data,
+                   [](const StatsRtu &rtu) { return double(rtu.pending); });
+    WriteRtuMetric(os, "tinyics_rtu_latency_mean_ms", "gauge", "Mean poll latency of the RTU",
+                   data, [](const StatsRtu &rtu) { return rtu.meanLatency; });
+    WriteRtuMetric(os, "tinyics_rtu_latency_p99_ms", "gauge", "99th percentile poll latency",
+                   data, [](const StatsRtu &rtu) { return rtu.p99Latency; });
+    WriteRtuMetric(os, "tinyics_rtu_latency_max_ms", "gauge", "Longest poll latency of the RTU",
+                   data, [](const StatsRtu &rtu) { return rtu.maxLatency; });
+
+    os.close();
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        std::cerr << "Failed to replace '" << path << "'\n";
+}
+
+} // namespace
+
+int
+main(int argc, char *argv[])
+{
+    std::string name = "/tinyics";
+    std::string prometheus;
+    long interval = 1000;
+    bool once = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:p:1")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            interval = std::atol(optarg);
+            break;
+        case 'p':
+            prometheus = optarg;
+            break;
+        case '1':
+            once = true;
+            break;
+        default:
+            std::cerr << "Usage: " << argv[0] << " [-i interval] [-p metrics.prom] [-1] [name]\n";
+            return 1;
+        }
+    }
+
+    if (optind < argc)
+        name = argv[optind];
+
+    if (interval <= 0)
+    {
+        std::cerr << "The interval should be greater than zero\n";
+        return 1;
+    }
+
+    const StatsBlock *block;
+    bool waiting = false;
+
+    // The simulation may not have started yet
+    while (!(block = MapSegment(name)) || block->magic != STATS_MAGIC)
+    {
+        if (block)
+            munmap(const_cast<StatsBlock *>(block), sizeof(StatsBlock));
+
+        if (once)
+        {
+            std::cerr << "No statistics published as '" << name << "'\n";
+            return 1;
+        }
+
+        if (!waiting)
+            std::cerr << "Waiting for '" << name << "'...\n";
+
+        waiting = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+    }
+
+    if (block->version != STATS_VERSION)
+    {
+        std::cerr << "'" << name << "' has layout version " << block->version << ", expected "
+                  << STATS_VERSION << '\n';
+        return 1;
+    }
+
+    StatsData data;
+
+    while (true)
+    {
+        if (!block->Read(data))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        Render(data);
+
+        if (!prometheus.empty())
+            WritePrometheus(prometheus, data);
+
+        if (once || data.finished)
+            break;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+    }
+
+    return 0;
+}